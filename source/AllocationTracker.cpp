@@ -0,0 +1,202 @@
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	// Keeps the blocks handed out aligned like the ones malloc returns
+	const size_t HEADER_SIZE = 16;
+
+	struct Header
+	{
+		size_t size;
+		int    tag;
+	};
+
+	struct Counts
+	{
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> frees;
+		std::atomic<uint64_t> freedBytes;
+	};
+
+	// Zero initialized before any code runs, so allocations made by other
+	// static constructors are counted too
+	Counts counts[AllocationTracker::TAG_COUNT];
+
+	thread_local int currentTag = AllocationTracker::OTHER;
+
+	void reportToCerr(void)
+	{
+		AllocationTracker::report(cerr);
+	}
+
+#ifdef CHESS_ALLOC_TRACKING
+	void* allocate(size_t size)
+	{
+		char* block = static_cast<char*>(malloc(size + HEADER_SIZE));
+		if (NULL == block)
+		{
+			return NULL;
+		}
+
+		Header* header = reinterpret_cast<Header*>(block);
+		header->size = size;
+		header->tag = currentTag;
+
+		Counts& tagCounts = counts[currentTag];
+		tagCounts.allocations.fetch_add(1, std::memory_order_relaxed);
+		tagCounts.bytes.fetch_add(size, std::memory_order_relaxed);
+		return block + HEADER_SIZE;
+	}
+
+	void release(void* memory)
+	{
+		if (NULL == memory)
+		{
+			return;
+		}
+
+		char* block = static_cast<char*>(memory) - HEADER_SIZE;
+		const Header* header = reinterpret_cast<const Header*>(block);
+
+		// Counted against the tag it was made under, whoever frees it
+		Counts& tagCounts = counts[header->tag];
+		tagCounts.frees.fetch_add(1, std::memory_order_relaxed);
+		tagCounts.freedBytes.fetch_add(header->size, std::memory_order_relaxed);
+		free(block);
+	}
+#endif
+}
+
+#ifdef CHESS_ALLOC_TRACKING
+static_assert(sizeof(Header) <= HEADER_SIZE, "The allocation header must fit in front of the block");
+
+// The array and nothrow forms are replaced too, so every block handed to
+// delete has the header in front of it whichever form made it
+void* operator new(std::size_t size)
+{
+	void* memory = allocate(size);
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	release(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	release(memory);
+}
+#endif
+
+AllocationTracker::Scope::Scope(Tag tag)
+{
+	previous = currentTag;
+	currentTag = tag;
+}
+
+AllocationTracker::Scope::~Scope()
+{
+	currentTag = previous;
+}
+
+AllocationTracker::Totals AllocationTracker::totals(Tag tag)
+{
+	const Counts& tagCounts = counts[tag];
+	Totals totals;
+	totals.allocations = tagCounts.allocations.load(std::memory_order_relaxed);
+	totals.bytes = tagCounts.bytes.load(std::memory_order_relaxed);
+
+	// A block made and freed between the reads would take live below zero
+	totals.liveBlocks = totals.allocations - std::min(totals.allocations, tagCounts.frees.load(std::memory_order_relaxed));
+	totals.liveBytes = totals.bytes - std::min(totals.bytes, tagCounts.freedBytes.load(std::memory_order_relaxed));
+	return totals;
+}
+
+AllocationTracker::Totals AllocationTracker::totals(void)
+{
+	Totals all = { 0, 0, 0, 0 };
+	for (int i = 0; i < TAG_COUNT; i++)
+	{
+		Totals tagTotals = totals(Tag(i));
+		all.allocations += tagTotals.allocations;
+		all.bytes += tagTotals.bytes;
+		all.liveBlocks += tagTotals.liveBlocks;
+		all.liveBytes += tagTotals.liveBytes;
+	}
+	return all;
+}
+
+const char* AllocationTracker::name(Tag tag)
+{
+	switch (tag)
+	{
+	case OTHER:   return "other";
+	case MOVE:    return "Move";
+	case HISTORY: return "history";
+	case GAME:    return "Game";
+	case MESSAGE: return "messages";
+	default:      return "unknown";
+	}
+}
+
+void AllocationTracker::report(std::ostream& out)
+{
+	if (!ENABLED)
+	{
+		out << "Allocation tracking is not compiled in (build with CHESS_ALLOC_TRACKING)\n";
+		return;
+	}
+
+	out << "Allocations      " << std::setw(14) << "count" << std::setw(14) << "bytes" << std::setw(14) << "live" << std::setw(14) << "live bytes" << "\n";
+	for (int i = 0; i <= TAG_COUNT; i++)
+	{
+		// The last line is the sum
+		Totals tagTotals = i < TAG_COUNT ? totals(Tag(i)) : totals();
+		out << "  " << std::left << std::setw(14) << (i < TAG_COUNT ? name(Tag(i)) : "total") << std::right
+			<< std::setw(14) << tagTotals.allocations << std::setw(14) << tagTotals.bytes
+			<< std::setw(14) << tagTotals.liveBlocks << std::setw(14) << tagTotals.liveBytes << "\n";
+	}
+}
+
+void AllocationTracker::reportAtExit(void)
+{
+	if (ENABLED)
+	{
+		atexit(reportToCerr);
+	}
+}
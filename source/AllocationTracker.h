@@ -0,0 +1,75 @@
+#pragma once
+#include "includes.h"
+#include <stdint.h>
+
+// Counts the allocations and bytes of every subsystem, and what is still
+// allocated when the process exits. Only compiled in with CHESS_ALLOC_TRACKING
+// defined (cmake -DCHESS_ALLOC_TRACKING=ON, make ALLOCS=1); the global operator
+// new and delete are then replaced by ones that put a small header in front of
+// every block with its size and the tag it was made under.
+// A tag is given to the code inside a CHESS_ALLOC_SCOPE and to everything it
+// calls, until an inner scope gives another one; it belongs to the thread, so
+// other threads are not affected. Whatever runs outside any scope is OTHER.
+// Without the define the scopes are nothing and the report says so
+class AllocationTracker
+{
+public:
+	enum Tag
+	{
+		OTHER = 0,
+		MOVE,     // Move construction
+		HISTORY,  // The plies, keys and captures a game records
+		GAME,     // Game objects, the session pools included
+		MESSAGE,  // Text for the user
+		TAG_COUNT
+	};
+
+#ifdef CHESS_ALLOC_TRACKING
+	static const bool ENABLED = true;
+#else
+	static const bool ENABLED = false;
+#endif
+
+	struct Totals
+	{
+		uint64_t allocations;
+		uint64_t bytes;
+		uint64_t liveBlocks; // Allocated and not freed yet
+		uint64_t liveBytes;
+	};
+
+	// Gives the tag to the allocations of the current thread while it lives
+	class Scope
+	{
+	public:
+		explicit Scope(Tag tag);
+		~Scope();
+
+	private:
+		int previous;
+
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+	};
+
+	static Totals totals(Tag tag);
+
+	// Every tag together
+	static Totals totals(void);
+
+	static const char* name(Tag tag);
+
+	// One line per tag, the blocks still allocated included
+	static void report(std::ostream& out);
+
+	// Reports to cerr when the process exits, in builds with the tracking. What
+	// is still allocated then has leaked, apart from the few objects that are
+	// meant to live as long as the process
+	static void reportAtExit(void);
+};
+
+#ifdef CHESS_ALLOC_TRACKING
+#define CHESS_ALLOC_SCOPE(tag) AllocationTracker::Scope allocationScope(AllocationTracker::tag)
+#else
+#define CHESS_ALLOC_SCOPE(tag) ((void)0)
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include "includes.h"
+#include <stdint.h>
+
+// Searches a fixed set of positions to a fixed depth. The node count only
+// changes when the search or the evaluation change, so it doubles as a
+// functional signature of the build; nodes per second is the speed figure
+class Bench
+{
+public:
+	static const int DEFAULT_DEPTH = 8;
+
+	struct Result
+	{
+		uint64_t nodes;
+		long long elapsed;
+	};
+
+	static Result run(int depth, std::ostream& out);
+
+	static const std::vector<std::string>& positions(void);
+};
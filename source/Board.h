@@ -0,0 +1,136 @@
+#pragma once
+#include "includes.h"
+#include "chess.h"
+#include <stdint.h>
+#include <type_traits>
+
+// Compact move used by the engine
+// Squares are numbered row * 8 + column, so A1 = 0, H1 = 7 and H8 = 63
+struct CompactMove
+{
+	uint8_t from;
+	uint8_t to;
+	char    promotion; // Upper case piece type, or 0 when there is no promotion
+	uint8_t flags;
+
+	static const uint8_t FLAG_CAPTURE     = 0x01;
+	static const uint8_t FLAG_EN_PASSANT  = 0x02;
+	static const uint8_t FLAG_CASTLING    = 0x04;
+	static const uint8_t FLAG_DOUBLE_PUSH = 0x08;
+	static const uint8_t FLAG_PROMOTION   = 0x10;
+
+	bool isNull(void) const { return from == to; }
+	bool isCapture(void) const { return 0 != (flags & (FLAG_CAPTURE | FLAG_EN_PASSANT)); }
+	bool isQuiet(void) const { return 0 == (flags & (FLAG_CAPTURE | FLAG_EN_PASSANT | FLAG_PROMOTION)); }
+
+	// Pack / unpack into 32 bits, used by the transposition table
+	uint32_t pack(void) const { return from | (to << 8) | ((uint8_t)promotion << 16) | (flags << 24); }
+	static CompactMove unpack(uint32_t data);
+	static CompactMove null(void);
+};
+
+inline bool operator==(const CompactMove& a, const CompactMove& b)
+{
+	return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
+
+inline bool operator!=(const CompactMove& a, const CompactMove& b)
+{
+	return !(a == b);
+}
+
+// Board state used by the engine. It keeps the same piece letters as Game
+// (upper case is white, 0x20 is an empty square) but it is trivially copyable,
+// so the search can copy it, make a move on the copy and just drop it afterwards
+class Board
+{
+public:
+	static const int CASTLE_WHITE_KING  = 0x01;
+	static const int CASTLE_WHITE_QUEEN = 0x02;
+	static const int CASTLE_BLACK_KING  = 0x04;
+	static const int CASTLE_BLACK_QUEEN = 0x08;
+
+	static const int NO_SQUARE = -1;
+	static const int MAX_MOVES = 256;
+
+	static const char* START_FEN;
+
+	struct MoveList
+	{
+		CompactMove moves[MAX_MOVES];
+		int count;
+	};
+
+	char     squares[64];
+	int      sideToMove;      // Chess::WHITE_PLAYER or Chess::BLACK_PLAYER
+	int      castlingRights;  // CASTLE_* bits
+	int      enPassantSquare; // Square behind a pawn that just made a double move, or NO_SQUARE
+	int      halfmoveClock;
+	int      fullmoveNumber;
+	int      kingSquare[2];
+	uint64_t hash;
+
+	void setStartPosition(void);
+
+	bool setFromFen(const std::string& fen);
+
+	std::string toFen(void) const;
+
+	char getPiece(int square) const { return squares[square]; }
+
+	int findKing(int color) const { return kingSquare[color]; }
+
+	bool isSquareAttacked(int square, int byColor) const;
+
+	bool isInCheck(void) const;
+
+	// Pseudo-legal moves: the king might be left in check, makeMove() tells
+	void generateMoves(MoveList& list, bool capturesOnly = false) const;
+
+	void generateLegalMoves(MoveList& list) const;
+
+	// Returns false (and leaves the board in an undefined state) if the move
+	// would leave the player's own king in check. Work on a copy.
+	bool makeMove(const CompactMove& move);
+
+	void makeNullMove(void);
+
+	bool hasNonPawnMaterial(int color) const;
+
+	// Neither side can mate: bare kings, a single minor piece, or bishops all on one square color
+	bool isInsufficientMaterial(void) const;
+
+	// History holds the hash keys of the positions before this one, oldest first
+	Chess::TerminalState terminalState(const std::vector<uint64_t>& history) const;
+
+	// Move text: "e2e4" / "e7e8q" (UCI) and "E2-E4" / "E7-E8=Q" (saved games)
+	static std::string toUci(const CompactMove& move);
+
+	static std::string toRecord(const CompactMove& move);
+
+	// Both return a null move if the text does not match a legal move
+	CompactMove parseUci(const std::string& text) const;
+
+	CompactMove parseRecord(const std::string& text) const;
+
+	// The legal move between the two squares, promotion is an upper case piece type or 0
+	CompactMove findMove(int from, int to, char promotion) const;
+
+	uint64_t computeHash(void) const;
+
+	uint64_t perft(int depth) const;
+
+	static int makeSquare(int row, int column) { return row * 8 + column; }
+	static int rowOf(int square) { return square >> 3; }
+	static int columnOf(int square) { return square & 7; }
+
+private:
+	void clear(void);
+
+	bool canCaptureEnPassant(void) const;
+
+	void addPawnMoves(MoveList& list, int from, int to, uint8_t flags) const;
+};
+
+// Game keeps its position in a Board too, so forking one must stay a plain copy
+static_assert(std::is_trivially_copyable<Board>::value, "Board must be trivially copyable");
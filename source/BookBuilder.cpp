@@ -0,0 +1,152 @@
+#include "BookBuilder.h"
+#include <algorithm>
+
+namespace
+{
+	void writeBigEndian(std::ostream& os, uint64_t value, int bytes)
+	{
+		for (int i = bytes - 1; i >= 0; i--)
+		{
+			os.put(char((value >> (8 * i)) & 0xFF));
+		}
+	}
+}
+
+BookBuilder::BookBuilder(int maxPlies)
+	: maxPlies(maxPlies)
+{
+	games = 0;
+}
+
+bool BookBuilder::addGame(const std::string& fileName)
+{
+	std::ifstream ifs(fileName);
+	if (!ifs)
+	{
+		return false;
+	}
+
+	std::deque<Game::Round> rounds;
+	std::vector<std::string> tags;
+	Game::loadRounds(ifs, rounds, &tags);
+
+	int whiteResult = -1;
+	for (size_t i = 0; i < tags.size(); i++)
+	{
+		if (0 != tags[i].compare(0, 9, "[Result] "))
+		{
+			continue;
+		}
+
+		string result = tags[i].substr(9);
+		if (0 == result.compare(0, 7, "1/2-1/2"))  whiteResult = 1;
+		else if (0 == result.compare(0, 3, "1-0")) whiteResult = 2;
+		else if (0 == result.compare(0, 3, "0-1")) whiteResult = 0;
+	}
+
+	addGame(rounds, whiteResult);
+	return true;
+}
+
+void BookBuilder::addGame(const std::deque<Game::Round>& rounds, int whiteResult)
+{
+	Board board;
+	board.setStartPosition();
+	int plies = 0;
+
+	for (size_t i = 0; i < rounds.size() && plies < maxPlies; i++)
+	{
+		const string* moves[2] = { &rounds[i].whiteMove, &rounds[i].blackMove };
+		for (int j = 0; j < 2 && plies < maxPlies && !moves[j]->empty(); j++, plies++)
+		{
+			CompactMove move = board.parseRecord(*moves[j]);
+			if (move.isNull())
+			{
+				games++;
+				return;
+			}
+
+			Record record;
+			record.key = board.hash;
+			record.move = OpeningBook::encodeMove(move);
+			if (whiteResult < 0)
+			{
+				record.weight = 1;
+			}
+			else
+			{
+				record.weight = Chess::WHITE_PLAYER == board.sideToMove ? whiteResult : 2 - whiteResult;
+			}
+			records.push_back(record);
+
+			board.makeMove(move);
+		}
+	}
+
+	games++;
+}
+
+size_t BookBuilder::save(const std::string& fileName) const
+{
+	// Merge the same move in the same position
+	std::vector<Record> merged(records);
+	std::sort(merged.begin(), merged.end(), [](const Record& a, const Record& b)
+	{
+		return a.key != b.key ? a.key < b.key : a.move < b.move;
+	});
+
+	size_t count = 0;
+	for (size_t i = 0; i < merged.size(); i++)
+	{
+		if (count > 0 && merged[count - 1].key == merged[i].key && merged[count - 1].move == merged[i].move)
+		{
+			merged[count - 1].weight += merged[i].weight;
+		}
+		else
+		{
+			merged[count++] = merged[i];
+		}
+	}
+	merged.resize(count);
+
+	std::sort(merged.begin(), merged.end(), [](const Record& a, const Record& b)
+	{
+		return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+	});
+
+	std::ofstream ofs(fileName, std::ios::binary);
+	if (!ofs.is_open())
+	{
+		return 0;
+	}
+
+	size_t written = 0;
+	for (size_t first = 0; first < merged.size();)
+	{
+		// Weights are 16 bits: scale a position down when its heaviest move doesn't fit
+		size_t last = first;
+		while (last < merged.size() && merged[last].key == merged[first].key)
+		{
+			last++;
+		}
+		double scale = merged[first].weight > 0xFFFF ? double(0xFFFF) / merged[first].weight : 1.0;
+
+		for (size_t i = first; i < last; i++)
+		{
+			uint16_t weight = uint16_t(merged[i].weight * scale);
+			if (0 == weight)
+			{
+				continue; // Only ever lost, or scaled away
+			}
+
+			writeBigEndian(ofs, merged[i].key, 8);
+			writeBigEndian(ofs, merged[i].move, 2);
+			writeBigEndian(ofs, weight, 2);
+			writeBigEndian(ofs, 0, 4);
+			written++;
+		}
+		first = last;
+	}
+
+	return ofs.good() ? written : 0;
+}
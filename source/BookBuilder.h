@@ -0,0 +1,39 @@
+#pragma once
+#include "includes.h"
+#include "OpeningBook.h"
+#include "game.h"
+
+// Builds an OpeningBook from saved games. When a game has a "[Result]" tag
+// (chess_match writes one) the winner's moves count 2 and drawn games count 1,
+// otherwise every time a move was played counts 1
+class BookBuilder
+{
+public:
+	static const int DEFAULT_MAX_PLIES = 24;
+
+	explicit BookBuilder(int maxPlies = DEFAULT_MAX_PLIES);
+
+	// Reads a .dat file. Moves after the first one that doesn't replay are ignored.
+	// Returns false if the file can't be opened
+	bool addGame(const std::string& fileName);
+
+	// whiteResult is 2, 1 or 0 half points for white, or -1 when the result is unknown
+	void addGame(const std::deque<Game::Round>& rounds, int whiteResult);
+
+	size_t getGames(void) const { return games; }
+
+	// Sorted by key, moves of one position heaviest first. Returns the number of entries
+	size_t save(const std::string& fileName) const;
+
+private:
+	struct Record
+	{
+		uint64_t key;
+		uint16_t move;
+		uint32_t weight;
+	};
+
+	int maxPlies;
+	size_t games;
+	std::vector<Record> records;
+};
@@ -0,0 +1,118 @@
+#include "Counters.h"
+#include <cstdlib>
+#include <mutex>
+
+thread_local Counters::Block* Counters::local = NULL;
+
+namespace
+{
+	std::mutex& registryMutex(void)
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	void dumpToCerr(void)
+	{
+		Counters::dump(cerr);
+	}
+}
+
+std::vector<Counters::Block*>& Counters::blocks(void)
+{
+	// Never destroyed, so threads still counting while the process exits are fine
+	static std::vector<Block*>* all = new std::vector<Block*>();
+	return *all;
+}
+
+Counters::Block* Counters::registerThread(void)
+{
+	// Never freed either: the counts of a finished thread stay in the totals
+	Block* block = new Block();
+	for (int i = 0; i < COUNTER_COUNT; i++)
+	{
+		block->values[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+	blocks().push_back(block);
+	local = block;
+	return block;
+}
+
+Counters::Totals Counters::totals(void)
+{
+	Totals totals = { { 0 } };
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+	const std::vector<Block*>& all = blocks();
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		for (int j = 0; j < COUNTER_COUNT; j++)
+		{
+			totals.values[j] += all[i]->values[j].load(std::memory_order_relaxed);
+		}
+	}
+	return totals;
+}
+
+const char* Counters::name(Counter counter)
+{
+	switch (counter)
+	{
+	case UNDER_ATTACK:    return "underAttack";
+	case SQUARES_SCANNED: return "squaresScanned";
+	case OVERLAY_HITS:    return "overlayHits";
+	case IS_REACHABLE:    return "isReachable";
+	case LEGAL_MOVES:     return "legal";
+	case ILLEGAL_MOVES:   return "illegal";
+	default:              return "unknown";
+	}
+}
+
+void Counters::dump(std::ostream& out)
+{
+	if (!ENABLED)
+	{
+		out << "Counters are not compiled in (build with CHESS_COUNTERS)\n";
+		return;
+	}
+
+	Totals totals = Counters::totals();
+	out << "Rules counters:\n";
+	for (int i = 0; i < COUNTER_COUNT; i++)
+	{
+		out << "  " << std::left << std::setw(16) << name(Counter(i)) << std::right << std::setw(16) << totals.values[i] << "\n";
+	}
+
+	uint64_t calls = totals.values[UNDER_ATTACK];
+	if (calls > 0)
+	{
+		out << "  squares per underAttack " << std::fixed << std::setprecision(1) << double(totals.values[SQUARES_SCANNED]) / calls << "\n";
+	}
+
+	uint64_t verdicts = totals.values[LEGAL_MOVES] + totals.values[ILLEGAL_MOVES];
+	if (verdicts > 0)
+	{
+		out << "  legal verdicts " << std::fixed << std::setprecision(1) << 100.0 * totals.values[LEGAL_MOVES] / verdicts << "%\n";
+	}
+}
+
+std::string Counters::summary(void)
+{
+	Totals totals = Counters::totals();
+	std::string text;
+	for (int i = 0; i < COUNTER_COUNT; i++)
+	{
+		text += (0 == i ? "" : " ") + std::string(name(Counter(i))) + "=" + std::to_string(totals.values[i]);
+	}
+	return text;
+}
+
+void Counters::dumpAtExit(void)
+{
+	if (ENABLED)
+	{
+		atexit(dumpToCerr);
+	}
+}
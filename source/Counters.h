@@ -0,0 +1,86 @@
+#pragma once
+#include "includes.h"
+#include <stdint.h>
+#include <atomic>
+
+// Counts of what the rules do, to see which checks dominate a real workload
+// without a profiler. Only compiled in with CHESS_COUNTERS defined (cmake
+// -DCHESS_COUNTERS=ON, make COUNTERS=1); otherwise CHESS_COUNT is nothing and
+// the totals stay at zero.
+// Every thread bumps its own block, padded to a cache line on both sides, with
+// plain loads and stores: no locked instruction and no line bouncing between
+// cores. A dump adds up the blocks of every thread that ever counted, the ones
+// that have finished included
+class Counters
+{
+public:
+	enum Counter
+	{
+		UNDER_ATTACK = 0,  // Game::underAttack calls
+		SQUARES_SCANNED,   // Squares looked at by them, through considerMove
+		OVERLAY_HITS,      // Squares answered from the intended move instead of the board
+		IS_REACHABLE,      // Game::isReachable calls
+		LEGAL_MOVES,       // Rules::check verdicts
+		ILLEGAL_MOVES,
+		COUNTER_COUNT
+	};
+
+#ifdef CHESS_COUNTERS
+	static const bool ENABLED = true;
+#else
+	static const bool ENABLED = false;
+#endif
+
+	struct Totals
+	{
+		uint64_t values[COUNTER_COUNT];
+	};
+
+	static void add(Counter counter, uint64_t amount)
+	{
+		Block* block = local;
+		if (NULL == block)
+		{
+			block = registerThread();
+		}
+
+		// Only this thread writes the value, the dump only reads it
+		std::atomic<uint64_t>& value = block->values[counter];
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	static Totals totals(void);
+
+	static const char* name(Counter counter);
+
+	// One line per counter, then the squares per underAttack call and the share of legal verdicts
+	static void dump(std::ostream& out);
+
+	// One line, "name=value ..."
+	static std::string summary(void);
+
+	// Dumps to cerr when the process exits, in builds with the counters
+	static void dumpAtExit(void);
+
+private:
+	static const size_t CACHE_LINE = 64;
+
+	struct Block
+	{
+		char padding1[CACHE_LINE];
+		std::atomic<uint64_t> values[COUNTER_COUNT];
+		char padding2[CACHE_LINE];
+	};
+
+	static thread_local Block* local;
+
+	static std::vector<Block*>& blocks(void);
+
+	static Block* registerThread(void);
+};
+
+#ifdef CHESS_COUNTERS
+#define CHESS_COUNT(counter) Counters::add(Counters::counter, 1)
+#else
+#define CHESS_COUNT(counter) ((void)0)
+#endif
@@ -0,0 +1,224 @@
+#include "Engine.h"
+#include "Trace.h"
+
+Engine::Engine()
+	: table(TranspositionTable::DEFAULT_SIZE_MB)
+{
+	moveOverhead = TimeManager::DEFAULT_MOVE_OVERHEAD;
+	multiPv = 1;
+	searching.store(false);
+	stopRequested = false;
+	pondering = false;
+	setThreads(1);
+}
+
+Engine::~Engine()
+{
+	stop();
+	wait();
+}
+
+void Engine::setHashSize(size_t megabytes)
+{
+	wait();
+	table.resize(megabytes > MAX_HASH_MB ? MAX_HASH_MB : megabytes);
+}
+
+void Engine::setThreads(int count)
+{
+	wait();
+
+	if (count < 1)
+	{
+		count = 1;
+	}
+	else if (count > MAX_THREADS)
+	{
+		count = MAX_THREADS;
+	}
+
+	searches.clear();
+	for (int i = 0; i < count; i++)
+	{
+		searches.push_back(std::unique_ptr<Search>(new Search(table)));
+		searches.back()->setHelper(i > 0);
+		searches.back()->getTimeManager().setMoveOverhead(moveOverhead);
+		searches.back()->setTablebases(tablebases.isEmpty() ? nullptr : &tablebases);
+	}
+
+	// Helpers only fill the table, the main thread reports the lines
+	searches[0]->setMultiPv(multiPv);
+}
+
+void Engine::setMoveOverhead(int milliseconds)
+{
+	wait();
+
+	moveOverhead = milliseconds;
+	for (size_t i = 0; i < searches.size(); i++)
+	{
+		searches[i]->getTimeManager().setMoveOverhead(milliseconds);
+	}
+}
+
+void Engine::setMultiPv(int count)
+{
+	wait();
+
+	searches[0]->setMultiPv(count);
+	multiPv = searches[0]->getMultiPv();
+}
+
+int Engine::setTablebasePath(const std::string& directory)
+{
+	wait();
+
+	tablebases = Tablebases();
+	int loaded = directory.empty() ? 0 : tablebases.load(directory);
+	for (size_t i = 0; i < searches.size(); i++)
+	{
+		searches[i]->setTablebases(tablebases.isEmpty() ? nullptr : &tablebases);
+	}
+	return loaded;
+}
+
+void Engine::newGame(void)
+{
+	wait();
+	table.clear();
+}
+
+void Engine::start(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& history,
+	ResultCallback onIteration, ResultCallback onFinished)
+{
+	// Only one search at a time
+	wait();
+
+	stopRequested = false;
+	pondering = limits.ponder;
+	for (size_t i = 0; i < searches.size(); i++)
+	{
+		searches[i]->clearStop();
+	}
+
+	searching.store(true);
+	worker = std::thread(&Engine::run, this, board, limits, history, onIteration, onFinished);
+}
+
+void Engine::stop(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	stopSignal.notify_all();
+
+	for (size_t i = 0; i < searches.size(); i++)
+	{
+		searches[i]->stop();
+	}
+}
+
+void Engine::ponderHit(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pondering = false;
+	}
+	stopSignal.notify_all();
+
+	// Helpers search as infinite anyway
+	searches[0]->ponderHit();
+}
+
+void Engine::wait(void)
+{
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+Search::Result Engine::think(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& history)
+{
+	Search::Result result;
+	start(board, limits, history, ResultCallback(), [&result](const Search::Result& finished) { result = finished; });
+	wait();
+	return result;
+}
+
+uint64_t Engine::getNodes(void) const
+{
+	uint64_t nodes = 0;
+	for (size_t i = 0; i < searches.size(); i++)
+	{
+		nodes += searches[i]->getNodes();
+	}
+	return nodes;
+}
+
+void Engine::run(Board board, SearchLimits limits, std::vector<uint64_t> history, ResultCallback onIteration, ResultCallback onFinished)
+{
+	Trace::setThreadName("search");
+
+	// Helpers search until the main thread is done
+	std::vector<std::thread> helpers;
+	for (size_t i = 1; i < searches.size(); i++)
+	{
+		Search* helper = searches[i].get();
+		helpers.push_back(std::thread([helper, board, history, i]()
+		{
+			Trace::setThreadName("search helper " + std::to_string(i));
+			SearchLimits helperLimits;
+			helperLimits.infinite = true;
+			helper->think(board, helperLimits, history);
+		}));
+	}
+
+	// Report the nodes of all the threads together
+	Search& main = *searches[0];
+	main.setIterationCallback([this, onIteration](const Search::Result& iteration)
+	{
+		if (onIteration)
+		{
+			Search::Result total = iteration;
+			for (size_t i = 1; i < searches.size(); i++)
+			{
+				total.nodes += searches[i]->getNodes();
+			}
+			onIteration(total);
+		}
+	});
+
+	Search::Result result = main.think(board, limits, history);
+
+	// In infinite mode the best move must not be sent before we are told to stop,
+	// nor while pondering before the ponder hit
+	if (limits.infinite || limits.ponder)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		bool infinite = limits.infinite;
+		stopSignal.wait(lock, [this, infinite]() { return stopRequested || (!infinite && !pondering); });
+	}
+
+	for (size_t i = 1; i < searches.size(); i++)
+	{
+		searches[i]->stop();
+	}
+	for (size_t i = 0; i < helpers.size(); i++)
+	{
+		helpers[i].join();
+	}
+
+	for (size_t i = 1; i < searches.size(); i++)
+	{
+		result.nodes += searches[i]->getNodes();
+	}
+
+	searching.store(false);
+
+	if (onFinished)
+	{
+		onFinished(result);
+	}
+}
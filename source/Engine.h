@@ -0,0 +1,81 @@
+#pragma once
+#include "includes.h"
+#include "Search.h"
+#include "Tablebase.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs the search on a worker thread, so the caller stays free to handle a "stop".
+// With more than one thread the extra ones search the same position and
+// share what they find through the transposition table
+class Engine
+{
+public:
+	typedef std::function<void(const Search::Result&)> ResultCallback;
+
+	static const int MAX_THREADS = 64;
+	static const size_t MAX_HASH_MB = 4096;
+
+	Engine();
+	~Engine();
+
+	void setHashSize(size_t megabytes);
+
+	void setThreads(int count);
+
+	int getThreads(void) const { return int(searches.size()); }
+
+	void setMoveOverhead(int milliseconds);
+
+	// Best root moves reported with their own PV, see Search::setMultiPv
+	void setMultiPv(int count);
+
+	// Loads the endgame tables found in the directory, none for an empty path. Returns how many
+	int setTablebasePath(const std::string& directory);
+
+	// Forget everything learnt from the previous game
+	void newGame(void);
+
+	// Starts searching in the background. Both callbacks run on the worker thread.
+	// With limits.infinite the result is held back until stop() is called, with
+	// limits.ponder until stop() or ponderHit()
+	void start(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& history,
+		ResultCallback onIteration, ResultCallback onFinished);
+
+	void stop(void);
+
+	// The move pondered on was played: the search goes on with its other limits
+	void ponderHit(void);
+
+	// Blocks until the current search (if any) has finished
+	void wait(void);
+
+	bool isSearching(void) const { return searching.load(); }
+
+	// Convenience for tools: search and wait for the result
+	Search::Result think(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& history = std::vector<uint64_t>());
+
+	uint64_t getNodes(void) const;
+
+	TranspositionTable& getTable(void) { return table; }
+
+	Search& getMainSearch(void) { return *searches[0]; }
+
+private:
+	TranspositionTable table;
+	std::vector<std::unique_ptr<Search> > searches;
+	int moveOverhead;
+	int multiPv;
+	Tablebases tablebases;
+
+	std::thread worker;
+	std::atomic<bool> searching;
+
+	std::mutex mutex;
+	std::condition_variable stopSignal;
+	bool stopRequested;
+	bool pondering;
+
+	void run(Board board, SearchLimits limits, std::vector<uint64_t> history, ResultCallback onIteration, ResultCallback onFinished);
+};
@@ -0,0 +1,285 @@
+#include "Evaluation.h"
+#include <sstream>
+
+namespace
+{
+	const int MG_MATERIAL_VALUES[Evaluation::PIECE_KINDS] = { 100, 320, 330, 500, 900, 0 };
+	const int EG_MATERIAL_VALUES[Evaluation::PIECE_KINDS] = { 120, 300, 320, 520, 930, 0 };
+
+	// Tables are written the way the board is printed: the first line is the 8th rank
+	const int PAWN_MG[64] =
+	{
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		 50, 50, 50, 50, 50, 50, 50, 50,
+		 10, 10, 20, 30, 30, 20, 10, 10,
+		  5,  5, 10, 25, 25, 10,  5,  5,
+		  0,  0,  0, 20, 20,  0,  0,  0,
+		  5, -5,-10,  0,  0,-10, -5,  5,
+		  5, 10, 10,-20,-20, 10, 10,  5,
+		  0,  0,  0,  0,  0,  0,  0,  0,
+	};
+
+	const int PAWN_EG[64] =
+	{
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		 80, 80, 80, 80, 80, 80, 80, 80,
+		 50, 50, 50, 50, 50, 50, 50, 50,
+		 30, 30, 30, 30, 30, 30, 30, 30,
+		 15, 15, 15, 15, 15, 15, 15, 15,
+		  5,  5,  5,  5,  5,  5,  5,  5,
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		  0,  0,  0,  0,  0,  0,  0,  0,
+	};
+
+	const int KNIGHT_TABLE[64] =
+	{
+		-50,-40,-30,-30,-30,-30,-40,-50,
+		-40,-20,  0,  0,  0,  0,-20,-40,
+		-30,  0, 10, 15, 15, 10,  0,-30,
+		-30,  5, 15, 20, 20, 15,  5,-30,
+		-30,  0, 15, 20, 20, 15,  0,-30,
+		-30,  5, 10, 15, 15, 10,  5,-30,
+		-40,-20,  0,  5,  5,  0,-20,-40,
+		-50,-40,-30,-30,-30,-30,-40,-50,
+	};
+
+	const int BISHOP_TABLE[64] =
+	{
+		-20,-10,-10,-10,-10,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5, 10, 10,  5,  0,-10,
+		-10,  5,  5, 10, 10,  5,  5,-10,
+		-10,  0, 10, 10, 10, 10,  0,-10,
+		-10, 10, 10, 10, 10, 10, 10,-10,
+		-10,  5,  0,  0,  0,  0,  5,-10,
+		-20,-10,-10,-10,-10,-10,-10,-20,
+	};
+
+	const int ROOK_TABLE[64] =
+	{
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		  5, 10, 10, 10, 10, 10, 10,  5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		  0,  0,  0,  5,  5,  0,  0,  0,
+	};
+
+	const int QUEEN_TABLE[64] =
+	{
+		-20,-10,-10, -5, -5,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5,  5,  5,  5,  0,-10,
+		 -5,  0,  5,  5,  5,  5,  0, -5,
+		  0,  0,  5,  5,  5,  5,  0, -5,
+		-10,  5,  5,  5,  5,  5,  0,-10,
+		-10,  0,  5,  0,  0,  0,  0,-10,
+		-20,-10,-10, -5, -5,-10,-10,-20,
+	};
+
+	const int KING_MG[64] =
+	{
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-20,-30,-30,-40,-40,-30,-30,-20,
+		-10,-20,-20,-20,-20,-20,-20,-10,
+		 20, 20,  0,  0,  0,  0, 20, 20,
+		 20, 30, 10,  0,  0, 10, 30, 20,
+	};
+
+	const int KING_EG[64] =
+	{
+		-50,-40,-30,-20,-20,-30,-40,-50,
+		-30,-20,-10,  0,  0,-10,-20,-30,
+		-30,-10, 20, 30, 30, 20,-10,-30,
+		-30,-10, 30, 40, 40, 30,-10,-30,
+		-30,-10, 30, 40, 40, 30,-10,-30,
+		-30,-10, 20, 30, 30, 20,-10,-30,
+		-30,-30,  0,  0,  0,  0,-30,-30,
+		-50,-30,-30,-30,-30,-30,-30,-50,
+	};
+
+	const int* const MG_TABLES_PRINTED[Evaluation::PIECE_KINDS] = { PAWN_MG, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_MG };
+	const int* const EG_TABLES_PRINTED[Evaluation::PIECE_KINDS] = { PAWN_EG, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_EG };
+}
+
+Evaluation::Evaluation()
+{
+	for (int kind = 0; kind < PIECE_KINDS; kind++)
+	{
+		weights[MG_MATERIAL + kind] = MG_MATERIAL_VALUES[kind];
+		weights[EG_MATERIAL + kind] = EG_MATERIAL_VALUES[kind];
+
+		for (int square = 0; square < 64; square++)
+		{
+			// Square 0 is A1, which is the first entry of the last printed line
+			int printed = (7 - Board::rowOf(square)) * 8 + Board::columnOf(square);
+			weights[MG_TABLES + kind * 64 + square] = MG_TABLES_PRINTED[kind][printed];
+			weights[EG_TABLES + kind * 64 + square] = EG_TABLES_PRINTED[kind][printed];
+		}
+	}
+
+	refresh();
+}
+
+void Evaluation::setParameter(int index, int value)
+{
+	weights[index] = value;
+	refresh();
+}
+
+bool Evaluation::loadWeights(const std::string& fileName)
+{
+	std::ifstream ifs(fileName);
+	if (!ifs)
+	{
+		return false;
+	}
+
+	std::vector<int> values;
+	string line;
+	while (std::getline(ifs, line))
+	{
+		if (line.empty() || '#' == line[0])
+		{
+			continue;
+		}
+
+		std::istringstream stream(line);
+		int value;
+		while (stream >> value)
+		{
+			values.push_back(value);
+		}
+	}
+
+	if (PARAMETER_COUNT != int(values.size()))
+	{
+		return false;
+	}
+
+	// Same order as saveWeights(): the printed layout mirrors the rows, square ^ 56
+	for (int i = 0; i < MG_TABLES; i++)
+	{
+		weights[i] = values[i];
+	}
+	for (int table = MG_TABLES; table < PARAMETER_COUNT; table += 64)
+	{
+		for (int square = 0; square < 64; square++)
+		{
+			weights[table + square] = values[table + (square ^ 56)];
+		}
+	}
+
+	refresh();
+	return true;
+}
+
+bool Evaluation::saveWeights(const std::string& fileName) const
+{
+	static const char* names[PIECE_KINDS] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+
+	std::ofstream ofs(fileName);
+	if (!ofs.is_open())
+	{
+		return false;
+	}
+
+	ofs << "# Middle game material: pawn knight bishop rook queen king\n";
+	for (int kind = 0; kind < PIECE_KINDS; kind++)
+	{
+		ofs << weights[MG_MATERIAL + kind] << (kind + 1 < PIECE_KINDS ? " " : "\n");
+	}
+	ofs << "# End game material\n";
+	for (int kind = 0; kind < PIECE_KINDS; kind++)
+	{
+		ofs << weights[EG_MATERIAL + kind] << (kind + 1 < PIECE_KINDS ? " " : "\n");
+	}
+
+	for (int table = MG_TABLES; table < PARAMETER_COUNT; table += 64)
+	{
+		ofs << "# " << (table < EG_TABLES ? "Middle" : "End") << " game " << names[(table - MG_TABLES) / 64 % PIECE_KINDS] << " table\n";
+		for (int printed = 0; printed < 64; printed++)
+		{
+			ofs << std::setw(4) << weights[table + (printed ^ 56)] << (7 == (printed & 7) ? "\n" : " ");
+		}
+	}
+
+	return ofs.good();
+}
+
+void Evaluation::refresh(void)
+{
+	for (int kind = 0; kind < PIECE_KINDS; kind++)
+	{
+		for (int square = 0; square < 64; square++)
+		{
+			mgTable[kind][square] = weights[MG_MATERIAL + kind] + weights[MG_TABLES + kind * 64 + square];
+			egTable[kind][square] = weights[EG_MATERIAL + kind] + weights[EG_TABLES + kind * 64 + square];
+		}
+	}
+}
+
+int Evaluation::pieceKind(char piece)
+{
+	switch (piece & ~0x20)
+	{
+	case Chess::PIECE_TYPE_PAWN:   return PAWN;
+	case Chess::PIECE_TYPE_KNIGHT: return KNIGHT;
+	case Chess::PIECE_TYPE_BISHOP: return BISHOP;
+	case Chess::PIECE_TYPE_ROOK:   return ROOK;
+	case Chess::PIECE_TYPE_QUEEN:  return QUEEN;
+	case Chess::PIECE_TYPE_KING:   return KING;
+	default:                       return PIECE_KINDS;
+	}
+}
+
+int Evaluation::phaseWeight(int kind)
+{
+	static const int weight[PIECE_KINDS + 1] = { 0, 1, 1, 2, 4, 0, 0 };
+	return weight[kind];
+}
+
+int Evaluation::evaluate(const Board& board) const
+{
+	int mg = 0;
+	int eg = 0;
+	int phase = 0;
+
+	for (int square = 0; square < 64; square++)
+	{
+		char piece = board.squares[square];
+		if (Chess::EMPTY_FIELD == piece)
+		{
+			continue;
+		}
+
+		int kind = pieceKind(piece);
+		phase += phaseWeight(kind);
+
+		if (piece < 'a')
+		{
+			mg += mgTable[kind][square];
+			eg += egTable[kind][square];
+		}
+		else
+		{
+			// Mirror the square vertically, so black uses the same tables
+			mg -= mgTable[kind][square ^ 56];
+			eg -= egTable[kind][square ^ 56];
+		}
+	}
+
+	if (phase > MAX_PHASE)
+	{
+		phase = MAX_PHASE;
+	}
+
+	int score = (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE;
+
+	return Chess::WHITE_PLAYER == board.sideToMove ? score : -score;
+}
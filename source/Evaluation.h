@@ -0,0 +1,61 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+
+// Static evaluation: material and piece-square tables, blended between
+// middle game and end game by the amount of material left on the board
+class Evaluation
+{
+public:
+	// Piece kinds in table order
+	enum PieceKind
+	{
+		PAWN = 0,
+		KNIGHT,
+		BISHOP,
+		ROOK,
+		QUEEN,
+		KING,
+		PIECE_KINDS
+	};
+
+	// All the weights live in one flat array:
+	// middle game material, end game material, middle game tables, end game tables.
+	// Tables are indexed from WHITE's point of view (A1 = 0); black squares are mirrored
+	static const int MG_MATERIAL = 0;
+	static const int EG_MATERIAL = MG_MATERIAL + PIECE_KINDS;
+	static const int MG_TABLES = EG_MATERIAL + PIECE_KINDS;
+	static const int EG_TABLES = MG_TABLES + PIECE_KINDS * 64;
+	static const int PARAMETER_COUNT = EG_TABLES + PIECE_KINDS * 64;
+
+	// Game phase goes from MAX_PHASE (all pieces on the board) down to 0
+	static const int MAX_PHASE = 24;
+
+	Evaluation();
+
+	// Score in centipawns from the point of view of the side to move
+	int evaluate(const Board& board) const;
+
+	int getParameter(int index) const { return weights[index]; }
+
+	void setParameter(int index, int value);
+
+	// Text file with all the weights, tables printed the way the board is (8th rank first).
+	// Lines starting with '#' are comments. Both return false if the file can't be used
+	bool loadWeights(const std::string& fileName);
+
+	bool saveWeights(const std::string& fileName) const;
+
+	static int pieceKind(char piece);
+
+	static int phaseWeight(int kind);
+
+private:
+	int weights[PARAMETER_COUNT];
+
+	// Material folded into the tables, rebuilt whenever a weight changes
+	int mgTable[PIECE_KINDS][64];
+	int egTable[PIECE_KINDS][64];
+
+	void refresh(void);
+};
@@ -1,8 +1,14 @@
 #include "GameController.h"
+#include "Counters.h"
+#include "Trace.h"
+#include <sstream>
 
 GameController::GameController()
 {
 	this->currentGame = NULL;
+	this->hintKey = 0;
+	this->hintMove = CompactMove::null();
+	this->hintDepth = 0;
 }
 
 void GameController::loadMenu(void)
@@ -10,8 +16,7 @@ void GameController::loadMenu(void)
 	bool bRun = true;
 
 	// Clear screen an print the logo
-	clearScreen();
-	printLogo();
+	renderer.drawLogo(true);
 
 	string input = "";
 
@@ -22,7 +27,7 @@ void GameController::loadMenu(void)
 
 		// Get input from user
 		cout << "Type here: ";
-		getline(cin, input);
+		readInput(input);
 
 		try {
 			if (input.length() != 1)
@@ -42,10 +47,7 @@ void GameController::loadMenu(void)
 			case Game::MENU_OPTION_NEW:
 			{
 				newGame();
-				clearScreen();
-				printLogo();
-				printSituation(*currentGame);
-				printBoard(*currentGame);
+				renderer.drawGame(*currentGame, true);
 			}
 			break;
 
@@ -60,10 +62,7 @@ void GameController::loadMenu(void)
 					else
 					{
 						movePiece();
-						//clearScreen();
-						printLogo();
-						printSituation(*currentGame);
-						printBoard(*currentGame);
+						renderer.drawGame(*currentGame, false);
 					}
 				}
 				else
@@ -85,10 +84,7 @@ void GameController::loadMenu(void)
 				if (NULL != currentGame)
 				{
 					undoMove();
-					//clearScreen();
-					printLogo();
-					printSituation(*currentGame);
-					printBoard(*currentGame);
+					renderer.drawGame(*currentGame, false);
 				}
 				else
 				{
@@ -102,10 +98,7 @@ void GameController::loadMenu(void)
 				if (NULL != currentGame)
 				{
 					saveGame();
-					clearScreen();
-					printLogo();
-					printSituation(*currentGame);
-					printBoard(*currentGame);
+					renderer.drawGame(*currentGame, true);
 				}
 				else
 				{
@@ -114,13 +107,32 @@ void GameController::loadMenu(void)
 			}
 			break;
 
+			case Game::MENU_OPTION_HINT:
+			{
+				if (NULL == currentGame)
+				{
+					throw invalid_argument("No game running!\n");
+				}
+				else if (currentGame->isFinished())
+				{
+					throw invalid_argument("This game has already finished!\n");
+				}
+				showHint();
+			}
+			break;
+
+			case Game::MENU_OPTION_COUNTERS:
+			{
+				std::ostringstream dump;
+				Counters::dump(dump);
+				createNextMessage(dump.str());
+			}
+			break;
+
 			case Game::MENU_OPTION_LOAD:
 			{
 				loadGame();
-				clearScreen();
-				printLogo();
-				printSituation(*currentGame);
-				printBoard(*currentGame);
+				renderer.drawGame(*currentGame, true);
 			}
 			break;
 
@@ -143,381 +155,18 @@ void GameController::loadMenu(void)
 	}
 }
 
-bool GameController::isPawnMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	char piece = currentGame->getPieceAtPosition(currentMove->getPresent().row, currentMove->getPresent().column);
-	// Wants to move forward
-	if (currentMove->getFuture().column == currentMove->getPresent().column)
-	{
-		// Simple move forward
-		if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 1) ||
-			(Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 1))
-		{
-			if (EMPTY_SQUARE == currentGame->getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column))
-			{
-				valid = true;
-			}
-		}
-
-		// Double move forward
-		else if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 2) ||
-			(Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 2))
-		{
-			// This is only allowed if the pawn is in its original place
-			if (Chess::isWhitePiece(piece))
-			{
-				if (EMPTY_SQUARE == currentGame->getPieceAtPosition(currentMove->getFuture().row - 1, currentMove->getFuture().column) &&
-					EMPTY_SQUARE == currentGame->getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column) &&
-					1 == currentMove->getPresent().row)
-				{
-					valid = true;
-				}
-			}
-			else // if ( isBlackPiece(piece) )
-			{
-				if (EMPTY_SQUARE == currentGame->getPieceAtPosition(currentMove->getFuture().row + 1, currentMove->getFuture().column) &&
-					EMPTY_SQUARE == currentGame->getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column) &&
-					6 == currentMove->getPresent().row)
-				{
-					valid = true;
-				}
-			}
-		}
-		else
-		{
-			// This is invalid
-			return false;
-		}
-	}
-
-	// The "en passant" move
-	else if ((Chess::isWhitePiece(piece) && 4 == currentMove->getPresent().row && 5 == currentMove->getFuture().row && 1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)) ||
-		(Chess::isBlackPiece(piece) && 3 == currentMove->getPresent().row && 2 == currentMove->getFuture().row && 1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		// It is only valid if last move of the opponent was a double move forward by a pawn on a adjacent column
-		string last_move = currentGame->getLastMove();
-
-		// Parse the line
-		Chess::Position LastMoveFrom;
-		Chess::Position LastMoveTo;
-		currentGame->parseMove(last_move, &LastMoveFrom, &LastMoveTo);
-
-		// First of all, was it a pawn?
-		char chLstMvPiece = currentGame->getPieceAtPosition(LastMoveTo.row, LastMoveTo.column);
-
-		if (toupper(chLstMvPiece) != 'P')
-		{
-			return false;
-		}
-
-		// Did the pawn have a double move forward and was it an adjacent column?
-		if (2 == abs(LastMoveTo.row - LastMoveFrom.row) && 1 == abs(LastMoveFrom.column - currentMove->getPresent().column))
-		{
-			cout << "En passant move!\n";
-			valid = true;
-
-			currentMove->getEnPassant()->applied = true;
-			currentMove->getEnPassant()->PawnCaptured.row = LastMoveTo.row;
-			currentMove->getEnPassant()->PawnCaptured.column = LastMoveTo.column;
-		}
-	}
-
-	// Wants to capture a piece
-	else if (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column))
-	{
-		if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 1) || (Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 1))
-		{
-			// Only allowed if there is something to be captured in the square
-			if (EMPTY_SQUARE != currentGame->getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column))
-			{
-				valid = true;
-				cout << "Pawn captured a piece!\n";
-			}
-		}
-	}
-	else
-	{
-		// This is invalid
-		return false;
-	}
-
-	// If a pawn reaches its eight rank, it must be promoted to another piece
-	if ((Chess::isWhitePiece(piece) && 7 == currentMove->getFuture().row) ||
-		(Chess::isBlackPiece(piece) && 0 == currentMove->getFuture().row))
-	{
-		cout << "Pawn must be promoted!\n";
-		currentMove->getPromotion()->applied = true;
-	}
-	return valid;
-}
-
-bool GameController::isRookMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	// Horizontal move
-	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (currentMove->getFuture().column != currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
-		{
-			valid = true;
-		}
-	}
-	// Vertical move
-	else if ((currentMove->getFuture().row != currentMove->getPresent().row) && (currentMove->getFuture().column == currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::VERTICAL))
-		{
-			valid = true;
-		}
-	}
-	return valid;
-}
-
-bool GameController::isKnightMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	if ((2 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		valid = true;
-	}
-
-	else if ((1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (2 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		valid = true;
-	}
-	return valid;
-}
-
-bool GameController::isBishopMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	// Diagonal move
-	if (abs(currentMove->getFuture().row - currentMove->getPresent().row) == abs(currentMove->getFuture().column - currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::DIAGONAL))
-		{
-			valid = true;
-		}
-	}
-	return valid;
-}
-
-bool GameController::isQueenMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	// Horizontal move
-	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (currentMove->getFuture().column != currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
-		{
-			valid = true;
-		}
-	}
-	// Vertical move
-	else if ((currentMove->getFuture().row != currentMove->getPresent().row) && (currentMove->getFuture().column == currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::VERTICAL))
-		{
-			valid = true;
-		}
-	}
-
-	// Diagonal move
-	else if (abs(currentMove->getFuture().row - currentMove->getPresent().row) == abs(currentMove->getFuture().column - currentMove->getPresent().column))
-	{
-		// Check if there are no pieces on the way
-		if (currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::DIAGONAL))
-		{
-			valid = true;
-		}
-	}
-	return valid;
-}
-
-bool GameController::isKingMovementValid(Move* currentMove) const
-{
-	bool valid = false;
-	char piece = currentGame->getPieceAtPosition(currentMove->getPresent().row, currentMove->getPresent().column);
-	// Horizontal move by 1
-	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		valid = true;
-	}
-
-	// Vertical move by 1
-	else if ((currentMove->getFuture().column == currentMove->getPresent().column) && (1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)))
-	{
-		valid = true;
-	}
-
-	// Diagonal move by 1
-	else if ((1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		valid = true;
-	}
-
-	// Castling
-	else if ((currentMove->getFuture().row == currentMove->getPresent().row) && (2 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
-	{
-		// Castling is only allowed in these circunstances:
-
-		// 1. King is not in check
-		if (currentGame->isPlayerKingInCheck())
-		{
-			return false;
-		}
-
-		// 2. No pieces in between the king and the rook
-		if (!currentGame->isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
-		{
-			return false;
-		}
-
-		// 3. King and rook must not have moved yet;
-		// 4. King must not pass through a square that is attacked by an enemy piece
-		if (currentMove->getFuture().column > currentMove->getPresent().column)
-		{
-			// if currentMove->getFuture().column is greather, it means king side
-			if (!currentGame->isCastlingAllowed(Chess::Side::KING_SIDE, Chess::getPieceColor(piece)))
-			{
-				createNextMessage("Castling to the king side is not allowed.\n");
-				return false;
-			}
-			else
-			{
-				// Check if the square that the king skips is not under attack
-				Chess::Position currentPosition = { currentMove->getPresent().row, currentMove->getPresent().column + 1 };
-				Chess::UnderAttack square_skipped = currentGame->underAttack(currentPosition, currentGame->getCurrentTurn());
-				if (!square_skipped.underAttack)
-				{
-					// Fill the currentMove->getCastling() structure
-					currentMove->getCastling()->applied = true;
-
-					// currentMove->getPresent() position of the rook
-					currentMove->getCastling()->rookBefore.row = currentMove->getPresent().row;
-					currentMove->getCastling()->rookBefore.column = currentMove->getPresent().column + 3;
-
-					// currentMove->getFuture() position of the rook
-					currentMove->getCastling()->rookAfter.row = currentMove->getFuture().row;
-					currentMove->getCastling()->rookAfter.column = currentMove->getPresent().column + 1; // currentMove->getFuture().column -1
-
-					valid = true;
-				}
-			}
-		}
-		else //if (currentMove->getFuture().column < currentMove->getPresent().column)
-		{
-			// if currentMove->getPresent().column is greather, it means queen side
-			if (!currentGame->isCastlingAllowed(Chess::Side::QUEEN_SIDE, Chess::getPieceColor(piece)))
-			{
-				createNextMessage("Castling to the queen side is not allowed.\n");
-				return false;
-			}
-			else
-			{
-				// Check if the square that the king skips is not attacked
-				Chess::Position currentPosition = { currentMove->getPresent().row, currentMove->getPresent().column - 1 };
-				Chess::UnderAttack square_skipped = currentGame->underAttack(currentPosition, currentGame->getCurrentTurn());
-				if (!square_skipped.underAttack)
-				{
-					// Fill the currentMove->getCastling() structure
-					currentMove->getCastling()->applied = true;
-
-					// currentMove->getPresent() position of the rook
-					currentMove->getCastling()->rookBefore.row = currentMove->getPresent().row;
-					currentMove->getCastling()->rookBefore.column = currentMove->getPresent().column - 4;
-
-					// currentMove->getFuture() position of the rook
-					currentMove->getCastling()->rookAfter.row = currentMove->getFuture().row;
-					currentMove->getCastling()->rookAfter.column = currentMove->getPresent().column - 1; // currentMove->getFuture().column +1
-
-					valid = true;
-				}
-			}
-		}
-	}
-	return valid;
-}
-
-bool GameController::isPieceColourValid(Chess::Position present, Chess::Position future) const
-{
-	char piece = currentGame->getPieceAtPosition(present.row, present.column);
-	if (currentGame->isSquareOccupied(future.row, future.column)) {
-		char chAuxPiece = currentGame->getPieceAtPosition(future.row, future.column);
-		if (Chess::getPieceColor(piece) == Chess::getPieceColor(chAuxPiece)) {
-			cout << "Position is already taken by a piece of the same color\n";
-			return false;
-		}
-	}
-	return true;
-}
-
 bool GameController::isMoveValid(Move* currentMove) const
 {
-	bool valid = false;
-	char piece = currentGame->getPieceAtPosition(currentMove->getPresent().row, currentMove->getPresent().column);
-
-	// 1. Is the piece  allowed to move in that direction?
-	switch (toupper(piece))
-	{
-	case Chess::PIECE_TYPE_PAWN: {
-		valid = isPawnMovementValid(currentMove);
-		break;
-	}
-
-	case Chess::PIECE_TYPE_ROOK: {
-		valid = isRookMovementValid(currentMove);
-		break;
-	}
-
-	case Chess::PIECE_TYPE_KNIGHT: {
-		valid = isKnightMovementValid(currentMove);
-		break;
-	}
-
-	case Chess::PIECE_TYPE_BISHOP: {
-		valid = isBishopMovementValid(currentMove);
-		break;
-	}
-
-	case Chess::PIECE_TYPE_QUEEN: {
-		valid = isQueenMovementValid(currentMove);
-		break;
-	}
-
-	case Chess::PIECE_TYPE_KING: {
-		valid = isKingMovementValid(currentMove);
-		break;
-	}
-
-	default: {
-		cout << "!!!!Should not reach here. Invalid piece: " << char(piece) << "\n\n\n";
-		break;
-	}
-	}
+	// The rules are silent, the console prints what they report
+	Rules rules(*currentGame, [](Rules::Event event) { cout << Rules::describe(event) << "\n"; });
 
-	// If it is a move in an invalid direction, do not even bother to check the rest
-	if (!valid)
+	Rules::Reason reason = rules.check(*currentMove);
+	if (Rules::VALID != reason)
 	{
-		cout << "Piece is not allowed to move to that square\n";
+		cout << Rules::describe(reason) << "\n";
 		return false;
 	}
-
-	// 2. Is there another piece of the same color on the destination square?
-	valid = isPieceColourValid(currentMove->getPresent(), currentMove->getFuture());
-
-	// 3. Would the king be in check after the move?
-	if (valid && currentGame->wouldKingBeInCheck(piece, currentMove)) {
-		cout << "Move would put player's king in check\n";
-		valid = false;
-	}
-	return valid;
+	return true;
 }
 
 void GameController::makeTheMove(Move* currentMove)
@@ -554,12 +203,12 @@ void GameController::makeTheMove(Move* currentMove)
 
 void GameController::newGame(void)
 {
-	if (currentGame)
+	// The console plays one game, reset in place from then on
+	if (NULL != currentGame)
 	{
-		delete currentGame;
+		game.reset();
 	}
-
-	currentGame = new Game();
+	currentGame = &game;
 }
 
 void GameController::undoMove(void)
@@ -574,7 +223,7 @@ void GameController::undoMove(void)
 	createNextMessage("Last move was undone\n");
 }
 
-bool GameController::isPickedPieceValid(Chess::Position& present, std::string& record)
+bool GameController::isPickedPieceValid(Chess::Position& present)
 {
 	// Did the user pick a valid piece?
 	// Must check if:
@@ -594,11 +243,6 @@ bool GameController::isPickedPieceValid(Chess::Position& present, std::string& r
 		return false;
 	}
 
-	// Put in the string to be logged
-	record += present.column;
-	record += present.row;
-	record += "-";
-
 	// Convert column from ['A'-'H'] to [0x00-0x07]
 	present.column = present.column - 'A';
 
@@ -633,7 +277,7 @@ bool GameController::isPickedPieceValid(Chess::Position& present, std::string& r
 	return true;
 }
 
-bool GameController::isPickedHouseValid(Chess::Position& future, Chess::Position present, std::string& record)
+bool GameController::isPickedHouseValid(Chess::Position& future, Chess::Position present)
 {
 	future.column = toupper(future.column);
 
@@ -649,10 +293,6 @@ bool GameController::isPickedHouseValid(Chess::Position& future, Chess::Position
 		return false;
 	}
 
-	// Put in the string to be logged
-	record += future.column;
-	record += future.row;
-
 	// Convert columns from ['A'-'H'] to [0x00-0x07]
 	future.column = future.column - 'A';
 
@@ -668,7 +308,7 @@ bool GameController::isPickedHouseValid(Chess::Position& future, Chess::Position
 	return true;
 }
 
-bool GameController::isPromotionSuccessful(Move& currentMove, std::string& record)
+bool GameController::isPromotionSuccessful(Move& currentMove)
 {
 	cout << "Promote to (Q, R, N, B): ";
 	std::string piece;
@@ -703,9 +343,6 @@ bool GameController::isPromotionSuccessful(Move& currentMove, std::string& recor
 		promotion.after = tolower(promoted);
 	}
 	currentMove.setPromotion(&promotion);
-
-	record += '=';
-	record += toupper(promoted); // always log with a capital letter
 	return true;
 }
 
@@ -743,13 +380,12 @@ void GameController::checkIfKingInCheck() const
 void GameController::movePiece(void)
 {
 	Move currentMove;
-	std::string record;
 
 	// Get user input for the piece they want to move
 	cout << "Choose piece to be moved. (example: A1 or b2): ";
 
 	std::string move_from;
-	getline(cin, move_from);
+	readInput(move_from);
 
 	if (move_from.length() > 2)
 	{
@@ -760,7 +396,7 @@ void GameController::movePiece(void)
 	present.column = move_from[0];
 	present.row = move_from[1];
 
-	if (!this->isPickedPieceValid(present, record)) {
+	if (!this->isPickedPieceValid(present)) {
 		return;
 	}
 	currentMove.setPresent(present);
@@ -768,7 +404,7 @@ void GameController::movePiece(void)
 	// Get user input for the square to move to
 	cout << "Move to: ";
 	std::string move_to;
-	getline(cin, move_to);
+	readInput(move_to);
 
 	if (move_to.length() > 2)
 	{
@@ -784,7 +420,7 @@ void GameController::movePiece(void)
 	future.column = move_to[0];
 	future.row = move_to[1];
 
-	if (!this->isPickedHouseValid(future, present, record)) {
+	if (!this->isPickedHouseValid(future, present)) {
 		return;
 	}
 	currentMove.setFuture(future);
@@ -799,7 +435,7 @@ void GameController::movePiece(void)
 	// Promotion: user must choose a piece to replace the pawn
 	if (currentMove.getPromotion()->applied)
 	{
-		if (!this->isPromotionSuccessful(currentMove, record)) {
+		if (!this->isPromotionSuccessful(currentMove)) {
 			return;
 		}
 		else {
@@ -807,10 +443,6 @@ void GameController::movePiece(void)
 		}
 	}
 
-	// Log the move: do it prior to making the move
-	// because we need the getCurrentTurn()
-	currentGame->logMove(record);
-
 	// Make the move
 	makeTheMove(&currentMove);
 
@@ -825,29 +457,27 @@ void GameController::saveGame(void)
 	cout << "Type file name to be saved (no extension): ";
 
 	getline(cin, file_name);
-	file_name += ".dat";
-
-	std::ofstream ofs(file_name);
-	if (ofs.is_open())
+	if (!saveGameFile(file_name + ".dat"))
 	{
-		// Write the date and time of save operation
-		auto time_now = std::chrono::system_clock::now();
-		std::time_t end_time = std::chrono::system_clock::to_time_t(time_now);
-		ofs << "[Chess console] Saved at: " << std::ctime(&end_time);
+		cout << "Error creating file! Save failed\n";
+	}
+}
 
-		// Write the moves
-		for (unsigned i = 0; i < currentGame->rounds.size(); i++)
-		{
-			ofs << currentGame->rounds[i].whiteMove.c_str() << " | " << currentGame->rounds[i].blackMove.c_str() << "\n";
-		}
+bool GameController::saveGameFile(const std::string& file_name)
+{
+	CHESS_TRACE_SPAN("save");
 
-		ofs.close();
-		createNextMessage("Game saved as " + file_name + "\n");
-	}
-	else
+	std::ofstream ofs(file_name);
+	if (!ofs.is_open())
 	{
-		cout << "Error creating file! Save failed\n";
+		return false;
 	}
+
+	currentGame->save(ofs);
+
+	ofs.close();
+	createNextMessage("Game saved as " + file_name + "\n");
+	return true;
 }
 
 bool GameController::isLoadedMoveValid(Move& currentMove, std::string loadedMove)
@@ -869,19 +499,18 @@ bool GameController::isLoadedMoveValid(Move& currentMove, std::string loadedMove
 		createNextMessage("[Invalid] Can't load this game because there are invalid lines!\n");
 
 		// Clear everything and return
-		currentGame = new Game();
+		newGame();
 		return false;
 	}
 	currentMove.setPresent(from);
 	currentMove.setFuture(to);
 	// Is that move allowed? (should be because we already validated before saving)
-
-	if (!isMoveValid(&currentMove))
+	if (Rules::VALID != Rules(*currentGame).check(currentMove))
 	{
 		createNextMessage("[Invalid] Can't load this game because there are invalid moves!\n");
 
 		// Clear everything and return
-		currentGame = new Game();
+		newGame();
 		return false;
 	}
 
@@ -896,7 +525,7 @@ bool GameController::isLoadedMoveValid(Move& currentMove, std::string loadedMove
 			createNextMessage("[Invalid] Can't load this game because there is an invalid promotion!\n");
 
 			// Clear everything and return
-			currentGame = new Game();
+			newGame();
 			return false;
 		}
 		Chess::Promotion promotion;
@@ -922,67 +551,255 @@ void GameController::loadGame(void)
 	cout << "Type file name to be loaded (no extension): ";
 
 	getline(cin, file_name);
-	file_name += ".dat";
+	loadGameFile(file_name + ".dat");
+}
+
+bool GameController::loadGameFile(const std::string& file_name)
+{
+	CHESS_TRACE_SPAN("load");
 
 	std::ifstream ifs(file_name);
 
 	if (ifs)
 	{
 		// First, reset the pieces
-		if (currentGame)
-		{
-			delete currentGame;
-		}
-		currentGame = new Game();
+		newGame();
 
 		// Now, read the lines from the file and then make the moves
-		std::string line;
+		std::deque<Game::Round> loaded;
+		Game::loadRounds(ifs, loaded);
 
-		while (std::getline(ifs, line))
+		for (unsigned round = 0; round < loaded.size(); round++)
 		{
-			// Skip lines that starts with "[]"
-			if (!line.compare(0, 1, "["))
-			{
-				continue;
-			}
-
 			// There might be one or two moves in the line
-			string loaded_move[2];
-
-			// Find the separator and subtract one
-			std::size_t separator = line.find(" |");
-
-			// For the first move, read from the beginning of the string until the separator
-			loaded_move[0] = line.substr(0, separator);
-
-			// For the second move, read from the separator until the end of the string (omit second parameter)
-			loaded_move[1] = line.substr(line.find("|") + 2);
+			string loaded_move[2] = { loaded[round].whiteMove, loaded[round].blackMove };
 
 			for (int i = 0; i < 2 && loaded_move[i] != ""; i++)
 			{
 				Move currentMove;
 				if (this->isLoadedMoveValid(currentMove, loaded_move[i])) 
 				{
-					// Log the move
-					currentGame->logMove(loaded_move[i]);
-
 					// Make the move
 					makeTheMove(&currentMove);
 				}
 				else {
-					return;
+					return false;
 				}				
 			}
 		}
 
 		// Extra line after the user input
 		createNextMessage("Game loaded from " + file_name + "\n");
-		return;
+		return true;
 	}
 	else
 	{
 		createNextMessage("Error loading " + file_name + ". Creating a new game instead\n");
-		currentGame = new Game();
+		newGame();
+		return false;
+	}
+}
+
+void GameController::readInput(std::string& input)
+{
+	// The engine only gets the CPU while we would be waiting anyway
+	startPondering();
+	getline(cin, input);
+	stopPondering();
+}
+
+void GameController::startPondering(void)
+{
+	if (NULL == currentGame || currentGame->isFinished())
+	{
 		return;
 	}
+
+	Board board;
+	std::vector<uint64_t> history;
+	currentGame->toBoard(board, history);
+
+	// A hint for the same position is kept, the search picks up from the table
+	if (board.hash != hintKey)
+	{
+		hintKey = board.hash;
+		hintMove = CompactMove::null();
+		hintDepth = 0;
+	}
+
+	SearchLimits limits;
+	limits.infinite = true;
+
+	// The main thread does not look at the hint before stopPondering() has joined the worker
+	engine.start(board, limits, history,
+		[this](const Search::Result& result)
+		{
+			if (!result.bestMove.isNull() && result.depth >= hintDepth)
+			{
+				hintMove = result.bestMove;
+				hintDepth = result.depth;
+			}
+		},
+		Engine::ResultCallback());
+}
+
+void GameController::stopPondering(void)
+{
+	engine.stop();
+	engine.wait();
+}
+
+void GameController::showHint(void)
+{
+	createNextMessage(describeHint() + "\n");
+}
+
+std::string GameController::describeHint(void)
+{
+	Board board;
+	std::vector<uint64_t> history;
+	currentGame->toBoard(board, history);
+
+	// Nothing pondered yet, e.g. the game has just been loaded
+	if (board.hash != hintKey || hintMove.isNull())
+	{
+		SearchLimits limits;
+		limits.moveTime = HINT_TIME;
+		Search::Result result = engine.think(board, limits, history);
+
+		hintKey = board.hash;
+		hintMove = result.bestMove;
+		hintDepth = result.depth;
+	}
+
+	if (hintMove.isNull())
+	{
+		return "No hint available for this game";
+	}
+	return "Hint: " + board.toRecord(hintMove) + " (depth " + std::to_string(hintDepth) + ")";
+}
+
+int GameController::runScript(std::istream& is, std::ostream& os)
+{
+	auto start = std::chrono::steady_clock::now();
+	int commands = 0;
+	int moves = 0;
+	int rejected = 0;
+
+	string line;
+	int lineNumber = 0;
+	bool quit = false;
+	while (!quit && std::getline(is, line))
+	{
+		lineNumber++;
+
+		std::istringstream stream(line);
+		string command;
+		if (!(stream >> command) || '#' == command[0])
+		{
+			continue;
+		}
+		commands++;
+
+		string arguments[3];
+		stream >> arguments[0] >> arguments[1] >> arguments[2];
+
+		string error;
+		switch (1 == command.length() ? toupper(command[0]) : 0)
+		{
+		case Game::MENU_OPTION_NEW:
+			newGame();
+			break;
+
+		case Game::MENU_OPTION_MOVE:
+			if (NULL == currentGame || currentGame->isFinished())
+			{
+				error = NULL == currentGame ? "No game running" : "This game has already finished";
+			}
+			else if (Rules::play(*currentGame, arguments[0], arguments[1], arguments[2], error))
+			{
+				moves++;
+			}
+			break;
+
+		case Game::MENU_OPTION_UNDO:
+			if (NULL == currentGame || !currentGame->isUndoPossible())
+			{
+				error = "Undo is not possible now";
+			}
+			else
+			{
+				currentGame->undoLastMove();
+			}
+			break;
+
+		case Game::MENU_OPTION_SAVE:
+			if (NULL == currentGame)
+			{
+				error = "No game running";
+			}
+			else if (!saveGameFile(arguments[0] + ".dat"))
+			{
+				error = "Save failed";
+			}
+			break;
+
+		case Game::MENU_OPTION_LOAD:
+			if (!loadGameFile(arguments[0] + ".dat"))
+			{
+				error = "Can't load " + arguments[0] + ".dat";
+			}
+			break;
+
+		case Game::MENU_OPTION_HINT:
+			if (NULL == currentGame || currentGame->isFinished())
+			{
+				error = "No hint available";
+			}
+			else
+			{
+				os << describeHint() << "\n";
+			}
+			break;
+
+		case Game::MENU_OPTION_COUNTERS:
+			Counters::dump(os);
+			break;
+
+		case Game::MENU_OPTION_QUIT:
+			quit = true;
+			break;
+
+		default:
+			error = "Option does not exist";
+			break;
+		}
+
+		if (!error.empty())
+		{
+			rejected++;
+			os << "line " << lineNumber << ": " << error << "\n";
+		}
+	}
+
+	long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	if (NULL != currentGame)
+	{
+		Board board;
+		std::vector<uint64_t> history;
+		currentGame->toBoard(board, history);
+		os << "Final position: " << board.toFen() << "\n";
+		os << "Final state   : " << Chess::describeTerminalState(currentGame->terminalState()) << "\n";
+	}
+	os << "Commands      : " << commands << " (" << rejected << " rejected)\n";
+	os << "Moves played  : " << moves << "\n";
+	os << "Time          : " << elapsed / 1000 << " ms";
+	if (elapsed > 0)
+	{
+		os << ", " << uint64_t(moves) * 1000000 / uint64_t(elapsed) << " moves/second";
+	}
+	os << "\n";
+
+	return rejected;
 }
@@ -5,34 +5,56 @@
 #include "debug.h"
 #include "game.h"
 #include "Move.h"
+#include "Rules.h"
+#include "Renderer.h"
+#include "Engine.h"
 
 class GameController
 {
 public:
 	GameController();
 	void loadMenu(void);
+	void setDifferentialRedraw(bool enabled) { renderer.setDifferential(enabled); }
+
+	// Runs menu commands from a stream, one per line, with no prompts or redraws:
+	//   N | M <from> <to> [Q|R|N|B] | U | S <file> | L <file> | H | Q
+	// Only rejected commands, hints and a final summary with the timing are printed.
+	// Returns the number of rejected commands
+	int runScript(std::istream& is, std::ostream& os);
 
 private:
+	// Search time for a hint when nothing has been pondered yet, in milliseconds
+	static const int HINT_TIME = 500;
+
+	// The game being played: game once the first one is started, NULL before
+	Game game;
 	Game* currentGame;
+	Renderer renderer;
+
+	// Searches the current game while the user is typing, so a hint is ready at once
+	Engine engine;
+	uint64_t hintKey;     // Position the hint belongs to
+	CompactMove hintMove;
+	int hintDepth;
 
-	bool isPawnMovementValid(Move* currentMove) const;
-	bool isRookMovementValid(Move* currentMove) const;
-	bool isKnightMovementValid(Move* currentMove) const;
-	bool isBishopMovementValid(Move* currentMove) const;
-	bool isQueenMovementValid(Move* currentMove) const;
-	bool isKingMovementValid(Move* currentMove) const;
-	bool isPieceColourValid(Chess::Position present, Chess::Position future) const;
 	bool isMoveValid(Move* currentMove) const;
 	void makeTheMove(Move* currentMove);
 	void newGame(void);
 	void undoMove(void);
-	bool isPickedPieceValid(Chess::Position& present, std::string& record);
-	bool isPickedHouseValid(Chess::Position& future, Chess::Position present, std::string& record);
-	bool isPromotionSuccessful(Move& currentMove, std::string& record);
+	bool isPickedPieceValid(Chess::Position& present);
+	bool isPickedHouseValid(Chess::Position& future, Chess::Position present);
+	bool isPromotionSuccessful(Move& currentMove);
 	void checkIfKingInCheck() const;
 	void movePiece(void);
 	void saveGame(void);
 	bool isLoadedMoveValid(Move& currentMove, std::string loadedMove);
 	void loadGame(void);
+	void readInput(std::string& input);
+	void startPondering(void);
+	void stopPondering(void);
+	void showHint(void);
+	std::string describeHint(void);
+	bool saveGameFile(const std::string& fileName);
+	bool loadGameFile(const std::string& fileName);
 };
 
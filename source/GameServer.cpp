@@ -0,0 +1,896 @@
+#include "GameServer.h"
+#include "Rules.h"
+#include "Counters.h"
+#include "Trace.h"
+#include <algorithm>
+#include <sstream>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	// Epoll tags of the two descriptors that are not clients; client IDs count up from 1
+	const uint64_t LISTEN_EVENT = UINT64_MAX;
+	const uint64_t WAKE_EVENT = UINT64_MAX - 1;
+
+	const size_t MAX_EVENTS = 256;
+	const size_t READ_SIZE = 16384;
+
+	// Looks at an empty queue this many times before going to sleep
+	const int SPIN_ROUNDS = 64;
+
+	// The session a command line is about, INVALID_SESSION for "new" and "load"
+	SessionManager::SessionId findSession(const std::string& line, std::string& command)
+	{
+		size_t end = line.find(' ');
+		command = line.substr(0, end);
+		if (string::npos == end || "load" == command)
+		{
+			return SessionManager::INVALID_SESSION;
+		}
+		return strtoull(line.c_str() + end + 1, NULL, 10);
+	}
+
+	// Saved game names are plain file names, so a client can't reach outside the games directory
+	bool isPlainName(const std::string& name)
+	{
+		return !name.empty() && string::npos == name.find_first_of("/\\") && string::npos == name.find("..");
+	}
+
+	// A spectator frame about the last move of the game, see GameServer.h for the layout
+	void encodeDelta(GameServer::DeltaType type, SessionManager::SessionId session, Game& game, size_t plies, char* delta)
+	{
+		memset(delta, 0, GameServer::DELTA_SIZE);
+		delta[0] = char(type);
+		for (int i = 0; i < 8; i++)
+		{
+			delta[1 + i] = char(session >> (8 * i));
+		}
+		delta[9] = char(plies & 0xFF);
+		delta[10] = char(plies >> 8);
+
+		if (GameServer::DELTA_CLOSED == type || 0 == game.getPlyCount())
+		{
+			return;
+		}
+
+		const CompactMove& ply = game.getPly(game.getPlyCount() - 1);
+		delta[11] = char(ply.from);
+		delta[12] = char(ply.to);
+		delta[13] = ply.promotion;
+		delta[14] = char(ply.flags);
+
+		// The side to move now is the one that lost the piece
+		if (ply.isCapture())
+		{
+			delta[15] = game.getCaptured(game.getCurrentTurn()).back();
+		}
+	}
+}
+
+GameServer::Settings::Settings()
+{
+	socketPath = "chess.sock";
+	gamesDirectory = ".";
+	workers = std::max(1, int(std::thread::hardware_concurrency()));
+	sessions = 1024;
+	maxClients = 10000;
+	queueSize = 4096;
+	pinWorkers = false;
+}
+
+GameServer::Worker::Worker(size_t queueSize, size_t reserved, uint32_t index, uint32_t count)
+	: sessions(reserved, index, count), requests(queueSize)
+{
+	sleeping = false;
+	wakeFd = eventfd(0, EFD_CLOEXEC);
+}
+
+GameServer::Worker::~Worker()
+{
+	if (wakeFd >= 0)
+	{
+		close(wakeFd);
+	}
+}
+
+GameServer::GameServer(const Settings& settings)
+	: settings(settings), replies(settings.queueSize)
+{
+	listenFd = -1;
+	epollFd = -1;
+	wakeFd = -1;
+	wakePending = false;
+	stopping = false;
+	nextWorker = 0;
+	nextConnection = 1;
+}
+
+GameServer::~GameServer()
+{
+	int descriptors[3] = { listenFd, epollFd, wakeFd };
+	for (int i = 0; i < 3; i++)
+	{
+		if (descriptors[i] >= 0)
+		{
+			close(descriptors[i]);
+		}
+	}
+}
+
+void GameServer::run(void)
+{
+	struct stat status;
+	if (0 != stat(settings.gamesDirectory.c_str(), &status) || !S_ISDIR(status.st_mode))
+	{
+		throw invalid_argument("The games directory " + settings.gamesDirectory + " does not exist\n");
+	}
+
+	openSocket();
+
+	// The games allocated up front are shared out between the workers
+	workers.clear();
+	uint32_t count = uint32_t(std::max(1, settings.workers));
+	size_t reserved = (settings.sessions + count - 1) / count;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		workers.push_back(std::unique_ptr<Worker>(new Worker(settings.queueSize, reserved, i, count)));
+		if (workers.back()->wakeFd < 0)
+		{
+			throw invalid_argument(string("Can't set up the workers: ") + strerror(errno) + "\n");
+		}
+	}
+
+	unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i]->thread = std::thread(&GameServer::work, this, std::ref(*workers[i]));
+		if (settings.pinWorkers)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(i % cores, &cpus);
+			pthread_setaffinity_np(workers[i]->thread.native_handle(), sizeof(cpus), &cpus);
+		}
+	}
+
+	Trace::setThreadName("server loop");
+
+	std::vector<epoll_event> events(MAX_EVENTS);
+	while (!stopping)
+	{
+		// Commands held back by a full queue are retried soon, not on the next event
+		int timeout = flushOverflow() ? -1 : 1;
+		int count = epoll_wait(epollFd, events.data(), int(events.size()), timeout);
+		if (count < 0)
+		{
+			if (EINTR == errno)
+			{
+				continue;
+			}
+			break;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			uint64_t tag = events[i].data.u64;
+			if (LISTEN_EVENT == tag)
+			{
+				acceptClients();
+			}
+			else if (WAKE_EVENT == tag)
+			{
+				// Cleared before the replies are taken, so a reply added meanwhile wakes the loop again
+				uint64_t value;
+				while (read(wakeFd, &value, sizeof(value)) > 0)
+				{
+				}
+				wakePending = false;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+			else
+			{
+				// A hang up may still come with the last commands, so read first. A client
+				// that quit is not read any more, nobody is left to take its replies
+				std::unordered_map<uint64_t, Connection>::iterator found = connections.find(tag);
+				if (connections.end() != found && found->second.quitting && (events[i].events & (EPOLLHUP | EPOLLERR)))
+				{
+					closeClient(tag);
+				}
+				else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				{
+					readClient(tag);
+				}
+				if ((events[i].events & EPOLLOUT) && connections.count(tag))
+				{
+					writeClient(tag);
+				}
+			}
+		}
+
+		// Replies that came in while the loop was busy need no wake up
+		collectReplies();
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		uint64_t one = 1;
+		if (write(workers[i]->wakeFd, &one, sizeof(one)) < 0)
+		{
+			// Still awake, it sees stopping by itself
+		}
+		workers[i]->thread.join();
+	}
+	workers.clear();
+
+	while (!connections.empty())
+	{
+		closeClient(connections.begin()->first);
+	}
+	unlink(settings.socketPath.c_str());
+}
+
+void GameServer::stop(void)
+{
+	stopping = true;
+	wake();
+}
+
+void GameServer::execute(SessionManager& sessions, const std::string& line, Reply& reply)
+{
+	CHESS_TRACE_SPAN("execute");
+
+	std::istringstream stream(line);
+	string command;
+	stream >> command;
+	reply.opened = SessionManager::INVALID_SESSION;
+	reply.session = SessionManager::INVALID_SESSION;
+	reply.watch = 0;
+	reply.delta[0] = DELTA_NONE;
+
+	if ("new" == command)
+	{
+		reply.opened = sessions.open();
+		reply.text = "ok " + std::to_string(reply.opened);
+		return;
+	}
+
+	if ("load" == command)
+	{
+		string name;
+		stream >> name;
+		if (!isPlainName(name))
+		{
+			reply.text = "error invalid game name " + name;
+			return;
+		}
+
+		std::ifstream ifs(gamePath(name));
+		if (!ifs)
+		{
+			reply.text = "error can't load " + name + ".dat";
+			return;
+		}
+
+		SessionManager::SessionId id = sessions.open();
+		string error;
+		if (!Rules::replay(*sessions.find(id), ifs, error))
+		{
+			sessions.close(id);
+			reply.text = "error " + error;
+			return;
+		}
+		reply.opened = id;
+		reply.text = "ok " + std::to_string(id);
+		return;
+	}
+
+	if ("stats" == command)
+	{
+		reply.text = Counters::ENABLED ? "ok " + Counters::summary() : "error counters are not compiled in";
+		return;
+	}
+
+	SessionManager::SessionId id = SessionManager::INVALID_SESSION;
+	stream >> id;
+	Game* game = sessions.find(id);
+	if (NULL == game)
+	{
+		reply.text = command.empty() ? "error empty command" : "error unknown session";
+		return;
+	}
+	reply.session = id;
+
+	if ("move" == command)
+	{
+		string from;
+		string to;
+		string promotion;
+		stream >> from >> to >> promotion;
+
+		string error;
+		if (game->isFinished())
+		{
+			reply.text = "error this game has already finished";
+		}
+		else if (!Rules::play(*game, from, to, promotion, error))
+		{
+			reply.text = "error " + error;
+		}
+		else
+		{
+			encodeDelta(DELTA_MOVE, id, *game, game->getPlyCount(), reply.delta);
+			reply.text = "ok " + Board::toRecord(game->getPly(game->getPlyCount() - 1));
+		}
+	}
+	else if ("undo" == command)
+	{
+		if (!game->isUndoPossible())
+		{
+			reply.text = "error undo is not possible now";
+			return;
+		}
+
+		// Encoded while the move and its capture are still there
+		encodeDelta(DELTA_UNDO, id, *game, game->getPlyCount() - 1, reply.delta);
+		game->undoLastMove();
+		reply.text = "ok";
+	}
+	else if ("state" == command || "watch" == command)
+	{
+		Board board;
+		std::vector<uint64_t> history;
+		game->toBoard(board, history);
+
+		reply.text = string("ok ") + Chess::terminalStateName(board.terminalState(history)) + " " + board.toFen();
+		if ("watch" == command)
+		{
+			// The snapshot the frames build on
+			reply.text.insert(3, std::to_string(game->getPlyCount()) + " ");
+			reply.watch = 1;
+		}
+	}
+	else if ("unwatch" == command)
+	{
+		reply.watch = -1;
+		reply.text = "ok";
+	}
+	else if ("save" == command)
+	{
+		CHESS_TRACE_SPAN("save");
+
+		string name;
+		stream >> name;
+		if (!isPlainName(name))
+		{
+			reply.text = "error invalid game name " + name;
+			return;
+		}
+
+		std::ofstream ofs(gamePath(name));
+		if (!ofs)
+		{
+			reply.text = "error can't save " + name + ".dat";
+			return;
+		}
+		game->save(ofs);
+		reply.text = "ok";
+	}
+	else if ("close" == command)
+	{
+		encodeDelta(DELTA_CLOSED, id, *game, game->getPlyCount(), reply.delta);
+		sessions.close(id);
+		reply.text = "ok";
+	}
+	else
+	{
+		reply.text = "error unknown command " + command;
+	}
+}
+
+std::string GameServer::gamePath(const std::string& name) const
+{
+	return settings.gamesDirectory + "/" + name + ".dat";
+}
+
+void GameServer::openSocket(void)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (settings.socketPath.empty() || settings.socketPath.size() >= sizeof(address.sun_path))
+	{
+		throw invalid_argument("Invalid socket path " + settings.socketPath + "\n");
+	}
+	strcpy(address.sun_path, settings.socketPath.c_str());
+
+	// A socket left behind by an earlier run is replaced, any other file is not
+	struct stat status;
+	if (0 == stat(address.sun_path, &status) && S_ISSOCK(status.st_mode))
+	{
+		unlink(address.sun_path);
+	}
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenFd < 0
+		|| bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0
+		|| listen(listenFd, SOMAXCONN) < 0)
+	{
+		throw invalid_argument("Can't listen on " + settings.socketPath + ": " + strerror(errno) + "\n");
+	}
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epollFd < 0 || wakeFd < 0)
+	{
+		throw invalid_argument(string("Can't set up the event loop: ") + strerror(errno) + "\n");
+	}
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.u64 = LISTEN_EVENT;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	event.data.u64 = WAKE_EVENT;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+void GameServer::acceptClients(void)
+{
+	for (;;)
+	{
+		int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			// EAGAIN once the backlog is empty. Out of descriptors, the rest wait in the backlog
+			return;
+		}
+
+		if (connections.size() >= settings.maxClients)
+		{
+			close(fd);
+			continue;
+		}
+
+		uint64_t id = nextConnection++;
+		Connection& connection = connections[id];
+		connection.fd = fd;
+		connection.nextSequence = 0;
+		connection.nextReply = 0;
+		connection.writing = false;
+		connection.quitting = false;
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u64 = id;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+	}
+}
+
+void GameServer::readClient(uint64_t id)
+{
+	CHESS_TRACE_SPAN("read");
+
+	std::unordered_map<uint64_t, Connection>::iterator found = connections.find(id);
+	if (connections.end() == found || found->second.quitting)
+	{
+		return;
+	}
+	Connection& connection = found->second;
+
+	// One read per event: the loop is level triggered, so a busy client can't starve the others
+	char buffer[READ_SIZE];
+	ssize_t size = read(connection.fd, buffer, sizeof(buffer));
+	if (size <= 0)
+	{
+		if (0 == size || (EAGAIN != errno && EINTR != errno))
+		{
+			closeClient(id);
+		}
+		return;
+	}
+	connection.input.append(buffer, size_t(size));
+
+	size_t start = 0;
+	size_t end;
+	while (!connection.quitting && string::npos != (end = connection.input.find('\n', start)))
+	{
+		string line = connection.input.substr(start, end - start);
+		start = end + 1;
+		if (!line.empty() && '\r' == line.back())
+		{
+			line.pop_back();
+		}
+
+		if (line.empty())
+		{
+			continue;
+		}
+		if ("quit" == line)
+		{
+			connection.quitting = true;
+			break;
+		}
+		dispatch(id, connection.nextSequence++, line);
+	}
+	connection.input.erase(0, start);
+
+	if (connection.input.size() > MAX_LINE)
+	{
+		closeClient(id);
+	}
+	else if (connection.quitting)
+	{
+		// Stop reading; writeClient() closes once the replies are out
+		connection.input.clear();
+		epoll_event event;
+		event.events = connection.writing ? uint32_t(EPOLLOUT) : 0u;
+		event.data.u64 = id;
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+		writeClient(id);
+	}
+}
+
+void GameServer::writeClient(uint64_t id)
+{
+	CHESS_TRACE_SPAN("write");
+
+	std::unordered_map<uint64_t, Connection>::iterator found = connections.find(id);
+	if (connections.end() == found)
+	{
+		return;
+	}
+	Connection& connection = found->second;
+
+	size_t sent = 0;
+	while (sent < connection.output.size())
+	{
+		ssize_t size = send(connection.fd, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL);
+		if (size > 0)
+		{
+			sent += size_t(size);
+		}
+		else if (EINTR == errno)
+		{
+			continue;
+		}
+		else if (EAGAIN == errno)
+		{
+			break;
+		}
+		else
+		{
+			closeClient(id);
+			return;
+		}
+	}
+	connection.output.erase(0, sent);
+
+	if (connection.quitting && connection.output.empty() && connection.nextReply == connection.nextSequence)
+	{
+		closeClient(id);
+		return;
+	}
+
+	// Only ask for EPOLLOUT while there is something left to write
+	bool waiting = !connection.output.empty();
+	if (waiting != connection.writing)
+	{
+		epoll_event event;
+		event.events = (connection.quitting ? 0u : uint32_t(EPOLLIN)) | (waiting ? uint32_t(EPOLLOUT) : 0u);
+		event.data.u64 = id;
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+		connection.writing = waiting;
+	}
+}
+
+void GameServer::closeClient(uint64_t id)
+{
+	std::unordered_map<uint64_t, Connection>::iterator found = connections.find(id);
+	if (connections.end() == found)
+	{
+		return;
+	}
+
+	// Closing the descriptor takes it out of the epoll set too
+	close(found->second.fd);
+
+	std::vector<SessionManager::SessionId> watched;
+	watched.swap(found->second.watching);
+	for (size_t i = 0; i < watched.size(); i++)
+	{
+		unwatch(id, watched[i]);
+	}
+
+	// Closed by the workers that own them, after any command still queued for them
+	const std::vector<SessionManager::SessionId>& owned = found->second.sessions;
+	for (size_t i = 0; i < owned.size(); i++)
+	{
+		dispatch(0, 0, "close " + std::to_string(owned[i]));
+	}
+	connections.erase(found);
+}
+
+void GameServer::collectReplies(void)
+{
+	CHESS_TRACE_SPAN("collect replies");
+
+	Reply reply;
+	std::vector<uint64_t> touched;
+	while (replies.pop(reply))
+	{
+		if (DELTA_NONE != reply.delta[0])
+		{
+			fanOut(reply.session, reply.delta, touched);
+		}
+
+		std::unordered_map<uint64_t, Connection>::iterator found = connections.find(reply.connection);
+		if (connections.end() == found)
+		{
+			// The client left before its new session was opened
+			if (SessionManager::INVALID_SESSION != reply.opened)
+			{
+				dispatch(0, 0, "close " + std::to_string(reply.opened));
+			}
+			continue;
+		}
+
+		Connection& connection = found->second;
+		if (SessionManager::INVALID_SESSION != reply.opened)
+		{
+			connection.sessions.push_back(reply.opened);
+		}
+
+		// Registered here, behind every frame the worker sent before its snapshot
+		if (1 == reply.watch && connection.watching.end() == std::find(connection.watching.begin(), connection.watching.end(), reply.session))
+		{
+			connection.watching.push_back(reply.session);
+			watchers[reply.session].push_back(reply.connection);
+		}
+		else if (-1 == reply.watch)
+		{
+			unwatch(reply.connection, reply.session);
+		}
+
+		// Workers finish out of order when the commands were for different sessions
+		if (reply.sequence != connection.nextReply)
+		{
+			connection.early[reply.sequence].swap(reply.text);
+			continue;
+		}
+
+		connection.output += reply.text;
+		connection.output += '\n';
+		connection.nextReply++;
+
+		std::map<uint64_t, std::string>::iterator next;
+		while (connection.early.end() != (next = connection.early.find(connection.nextReply)))
+		{
+			connection.output += next->second;
+			connection.output += '\n';
+			connection.early.erase(next);
+			connection.nextReply++;
+		}
+		touched.push_back(reply.connection);
+	}
+
+	for (size_t i = 0; i < touched.size(); i++)
+	{
+		writeClient(touched[i]);
+	}
+}
+
+void GameServer::fanOut(SessionManager::SessionId session, const char* delta, std::vector<uint64_t>& touched)
+{
+	std::unordered_map<SessionManager::SessionId, std::vector<uint64_t> >::iterator found = watchers.find(session);
+	if (watchers.end() == found)
+	{
+		return;
+	}
+
+	// Copied into every output, not referenced: a frame is smaller than a pointer with its count
+	std::vector<uint64_t> stalled;
+	const std::vector<uint64_t>& spectators = found->second;
+	for (size_t i = 0; i < spectators.size(); i++)
+	{
+		std::unordered_map<uint64_t, Connection>::iterator spectator = connections.find(spectators[i]);
+		if (connections.end() == spectator)
+		{
+			continue;
+		}
+
+		Connection& connection = spectator->second;
+		if (connection.output.size() + DELTA_SIZE > MAX_BACKLOG)
+		{
+			stalled.push_back(spectators[i]);
+			continue;
+		}
+		connection.output.append(delta, DELTA_SIZE);
+		touched.push_back(spectators[i]);
+
+		if (DELTA_CLOSED == delta[0])
+		{
+			connection.watching.erase(std::remove(connection.watching.begin(), connection.watching.end(), session), connection.watching.end());
+		}
+	}
+
+	if (DELTA_CLOSED == delta[0])
+	{
+		watchers.erase(found);
+	}
+	for (size_t i = 0; i < stalled.size(); i++)
+	{
+		closeClient(stalled[i]);
+	}
+}
+
+void GameServer::unwatch(uint64_t connection, SessionManager::SessionId session)
+{
+	std::unordered_map<uint64_t, Connection>::iterator found = connections.find(connection);
+	if (connections.end() != found)
+	{
+		std::vector<SessionManager::SessionId>& watching = found->second.watching;
+		watching.erase(std::remove(watching.begin(), watching.end(), session), watching.end());
+	}
+
+	std::unordered_map<SessionManager::SessionId, std::vector<uint64_t> >::iterator spectators = watchers.find(session);
+	if (watchers.end() != spectators)
+	{
+		std::vector<uint64_t>& list = spectators->second;
+		list.erase(std::remove(list.begin(), list.end(), connection), list.end());
+		if (list.empty())
+		{
+			watchers.erase(spectators);
+		}
+	}
+}
+
+void GameServer::dispatch(uint64_t connection, uint64_t sequence, const std::string& line)
+{
+	// Clients still connected when the server stops lose their games with the workers
+	if (workers.empty())
+	{
+		return;
+	}
+
+	string command;
+	SessionManager::SessionId session = findSession(line, command);
+
+	// The bookkeeping for closing the sessions of a client that goes away
+	std::unordered_map<uint64_t, Connection>::iterator found = connections.find(connection);
+	if ("close" == command && connections.end() != found)
+	{
+		std::vector<SessionManager::SessionId>& owned = found->second.sessions;
+		owned.erase(std::remove(owned.begin(), owned.end(), session), owned.end());
+	}
+
+	// A new game opens in the pool of the worker picked here, and its ID then
+	// brings every later command back to that worker
+	size_t index = SessionManager::INVALID_SESSION == session
+		? nextWorker++ % workers.size()
+		: SessionManager::poolOf(session, uint32_t(workers.size()));
+
+	Request request = { connection, sequence, line };
+	push(*workers[index], request);
+}
+
+bool GameServer::flushOverflow(void)
+{
+	bool flushed = true;
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		Worker& worker = *workers[i];
+		if (worker.overflow.empty())
+		{
+			continue;
+		}
+
+		while (!worker.overflow.empty() && worker.requests.push(std::move(worker.overflow.front())))
+		{
+			worker.overflow.pop_front();
+		}
+		wakeWorker(worker);
+		flushed = flushed && worker.overflow.empty();
+	}
+	return flushed;
+}
+
+void GameServer::push(Worker& worker, Request& request)
+{
+	// Nothing may overtake what is already held back
+	if (!worker.overflow.empty() || !worker.requests.push(std::move(request)))
+	{
+		worker.overflow.push_back(std::move(request));
+	}
+	wakeWorker(worker);
+}
+
+void GameServer::wakeWorker(Worker& worker)
+{
+	// Pairs with the fence in work(): either the worker sees the command or this sees it asleep
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (worker.sleeping.load(std::memory_order_relaxed) && worker.sleeping.exchange(false))
+	{
+		uint64_t one = 1;
+		if (write(worker.wakeFd, &one, sizeof(one)) < 0)
+		{
+			// The counter can't overflow with one write per sleep
+		}
+	}
+}
+
+void GameServer::work(Worker& worker)
+{
+	Request request;
+	Reply reply;
+	int idle = 0;
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (&worker == workers[i].get())
+		{
+			Trace::setThreadName("worker " + std::to_string(i));
+		}
+	}
+
+	while (!stopping)
+	{
+		if (!worker.requests.pop(request))
+		{
+			if (++idle < SPIN_ROUNDS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Say so before the last look, push() wakes the worker if it missed this command
+			worker.sleeping = true;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (worker.requests.empty() && !stopping)
+			{
+				uint64_t value;
+				if (read(worker.wakeFd, &value, sizeof(value)) < 0 && EINTR != errno)
+				{
+					return;
+				}
+			}
+			worker.sleeping = false;
+			idle = 0;
+			continue;
+		}
+		idle = 0;
+
+		execute(worker.sessions, request.line, reply);
+		if (0 == request.connection && DELTA_NONE == reply.delta[0])
+		{
+			continue;
+		}
+		reply.connection = request.connection;
+		reply.sequence = request.sequence;
+
+		// A full reply queue only means the loop is behind, it never waits for a worker
+		while (!replies.push(std::move(reply)))
+		{
+			std::this_thread::yield();
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!wakePending.load(std::memory_order_relaxed) && !wakePending.exchange(true))
+		{
+			wake();
+		}
+	}
+}
+
+void GameServer::wake(void)
+{
+	uint64_t one = 1;
+	if (wakeFd >= 0 && write(wakeFd, &one, sizeof(one)) < 0)
+	{
+		// Full counter: the loop is awake already
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include "includes.h"
+#include "SessionManager.h"
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+// Serves console games to many clients over a Unix domain socket, a local
+// stand-in for the real frontend. The protocol is one command per line and one
+// reply per line, in the order the commands were sent:
+//   new                        -> ok <session>
+//   move <session> e2 e4 [Q]   -> ok E2-E4
+//   undo <session>             -> ok
+//   state <session>            -> ok <ongoing|checkmate|stalemate|fifty|repetition|material> <FEN>
+//   save <session> <name>      -> ok          (writes <name>.dat in the games directory, like the console)
+//   load <name>                -> ok <session>
+//   close <session>            -> ok
+//   watch <session>            -> ok <plies> <state> <FEN>, then a frame for every change
+//   unwatch <session>          -> ok
+//   stats                      -> ok underAttack=<n> ... (the rules counters of every thread, see Counters.h)
+//   quit                       -> the server closes the connection
+// Anything that fails answers "error <reason>". Sessions opened by a connection
+// are closed when it goes away. A game name is a plain file name, without any
+// "/" or "..", so games are only read and written in the games directory.
+// Spectators get DELTA_SIZE byte binary frames instead of boards, told apart
+// from the replies by their first byte, the frame type:
+//   0     type: DELTA_MOVE, DELTA_UNDO (the move taken back) or DELTA_CLOSED
+//   1-8   session, little endian
+//   9-10  plies played after the change, little endian
+//   11-14 the move as recorded: from and to square (A1 = 0, H8 = 63), promotion, flags
+//   15    captured piece, 0 for none
+// A frame is encoded once by the worker and the same bytes go to every spectator.
+// Frames can overtake the replies to commands for other sessions; the ply count
+// places them against the position sent with the reply to watch.
+// One thread runs an epoll loop over all the sockets and only moves bytes; the
+// commands run on a pool of workers. Every worker keeps the games it opened in
+// its own SessionManager, and the session ID tells which one: a session always
+// goes to the same worker, so its commands run in order, its game is never
+// touched by two threads and looking it up takes no lock.
+// Commands reach a worker through its own single producer queue and the replies
+// come back through one shared queue, so handing a command over takes no lock;
+// a thread is only woken through an eventfd when it had gone to sleep
+class GameServer
+{
+public:
+	struct Settings
+	{
+		std::string socketPath;
+		std::string gamesDirectory; // Where save and load keep the games
+		int         workers;
+		size_t      sessions;  // Games allocated up front
+		size_t      maxClients;
+		size_t      queueSize; // Commands waiting for each worker, and replies waiting for the loop
+		bool        pinWorkers; // Keeps every worker, and so its games, on one core
+
+		Settings();
+	};
+
+	explicit GameServer(const Settings& settings);
+	~GameServer();
+
+	// Serves until stop() is called. Throws invalid_argument when the socket can't be set up
+	void run(void);
+
+	// Safe to call from any thread or from a signal handler
+	void stop(void);
+
+	enum DeltaType
+	{
+		DELTA_NONE = 0,
+		DELTA_MOVE,
+		DELTA_UNDO,
+		DELTA_CLOSED
+	};
+
+	static const size_t DELTA_SIZE = 16;
+
+private:
+	// Longest command line accepted; a client sending more is disconnected
+	static const size_t MAX_LINE = 4096;
+
+	// Bytes waiting for a client that doesn't read them before it is dropped. Keeps
+	// a stalled spectator of a busy game from growing without end
+	static const size_t MAX_BACKLOG = 1 << 20;
+
+	struct Request
+	{
+		uint64_t    connection; // 0 for the server's own requests, which get no reply
+		uint64_t    sequence;
+		std::string line;
+	};
+
+	struct Reply
+	{
+		uint64_t    connection;
+		uint64_t    sequence;
+		std::string text;
+		SessionManager::SessionId opened;
+		SessionManager::SessionId session; // The game the watch and the delta are about
+		int         watch;                 // 1 to start watching session, -1 to stop
+		char        delta[DELTA_SIZE];     // Frame for the spectators, DELTA_NONE type for none
+	};
+
+	struct Worker
+	{
+		SessionManager sessions; // Only touched by the worker thread
+		SpscQueue<Request> requests;
+		std::deque<Request> overflow; // Loop side only: commands that found the queue full
+		std::atomic<bool> sleeping;
+		int wakeFd;
+		std::thread thread;
+
+		Worker(size_t queueSize, size_t reserved, uint32_t index, uint32_t count);
+		~Worker();
+	};
+
+	struct Connection
+	{
+		int         fd;
+		std::string input;
+		std::string output;
+		uint64_t    nextSequence; // Given to the next command read
+		uint64_t    nextReply;    // The reply that has to be written next
+		std::map<uint64_t, std::string> early; // Replies that overtook an earlier one
+		std::vector<SessionManager::SessionId> sessions;
+		std::vector<SessionManager::SessionId> watching;
+		bool        writing;      // Waiting for EPOLLOUT
+		bool        quitting;     // Closes once every reply is out
+	};
+
+	Settings settings;
+
+	int listenFd;
+	int epollFd;
+	int wakeFd;   // eventfd the workers and stop() write to
+	std::atomic<bool> wakePending; // Set by the first reply after the loop last looked
+	std::atomic<bool> stopping;
+
+	std::vector<std::unique_ptr<Worker> > workers;
+	size_t nextWorker; // Round robin for the commands without a session, "new" and "load" among them
+
+	MpscQueue<Reply> replies;
+
+	std::unordered_map<uint64_t, Connection> connections;
+	uint64_t nextConnection;
+
+	// Spectator connections of every watched session
+	std::unordered_map<SessionManager::SessionId, std::vector<uint64_t> > watchers;
+
+	void openSocket(void);
+	void acceptClients(void);
+	void readClient(uint64_t id);
+	void writeClient(uint64_t id);
+	void closeClient(uint64_t id);
+	void collectReplies(void);
+
+	// The file of a saved game, the name must be a plain one
+	std::string gamePath(const std::string& name) const;
+
+	// Runs one command line against the sessions of the worker. The reply text goes without the newline
+	void execute(SessionManager& sessions, const std::string& line, Reply& reply);
+
+	// Queues the frame for every spectator of the session, touched gets the ones to write to
+	void fanOut(SessionManager::SessionId session, const char* delta, std::vector<uint64_t>& touched);
+
+	void unwatch(uint64_t connection, SessionManager::SessionId session);
+
+	// Sends a command to the worker that owns its session
+	void dispatch(uint64_t connection, uint64_t sequence, const std::string& line);
+
+	// Moves what the full queues held back into them. False while some is still waiting
+	bool flushOverflow(void);
+
+	void push(Worker& worker, Request& request);
+
+	void wakeWorker(Worker& worker);
+
+	void work(Worker& worker);
+
+	void wake(void);
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include "includes.h"
+#include <atomic>
+#include <memory>
+
+// Bounded queues for handing work between threads without a mutex. Both keep
+// their items in a ring of a power of two size allocated once; push() returns
+// false instead of waiting when the ring is full, so the caller decides whether
+// to spin, keep the item aside or drop it. Neither one blocks: a consumer with
+// nothing to do has to be woken some other way
+
+// Padding that keeps the producer and the consumer counters on separate cache
+// lines, whatever the alignment the queue ends up with
+static const size_t QUEUE_CACHE_LINE = 64;
+
+// One producer thread, one consumer thread
+template <typename T>
+class SpscQueue
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit SpscQueue(size_t capacity)
+	{
+		size = 2;
+		while (size < capacity)
+		{
+			size *= 2;
+		}
+		items.reset(new T[size]);
+		head = 0;
+		tail = 0;
+		cachedHead = 0;
+		cachedTail = 0;
+	}
+
+	// Producer side
+	bool push(T&& item)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		if (position - cachedHead >= size)
+		{
+			// Only read the consumer's counter when the ring looks full
+			cachedHead = head.load(std::memory_order_acquire);
+			if (position - cachedHead >= size)
+			{
+				return false;
+			}
+		}
+
+		items[position & (size - 1)] = std::move(item);
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool pop(T& item)
+	{
+		size_t position = head.load(std::memory_order_relaxed);
+		if (position == cachedTail)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (position == cachedTail)
+			{
+				return false;
+			}
+		}
+
+		item = std::move(items[position & (size - 1)]);
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Exact for the consumer, a snapshot for anybody else
+	bool empty(void) const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::unique_ptr<T[]> items;
+	size_t size;
+
+	char padding1[QUEUE_CACHE_LINE];
+	std::atomic<size_t> head;
+	size_t cachedTail; // The consumer's last look at tail
+
+	char padding2[QUEUE_CACHE_LINE];
+	std::atomic<size_t> tail;
+	size_t cachedHead; // The producer's last look at head
+	char padding3[QUEUE_CACHE_LINE];
+};
+
+// Any number of producer threads, one consumer thread. Every cell has a sequence
+// number saying whose turn it is: a producer claims a position with a
+// compare-exchange on the tail, then publishes the item by moving the cell's
+// sequence on, so the consumer never sees a half written item
+template <typename T>
+class MpscQueue
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit MpscQueue(size_t capacity)
+	{
+		size = 2;
+		while (size < capacity)
+		{
+			size *= 2;
+		}
+		cells.reset(new Cell[size]);
+		for (size_t i = 0; i < size; i++)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		head = 0;
+		tail = 0;
+	}
+
+	// Any thread
+	bool push(T&& item)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = cells[position & (size - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			if (sequence == position)
+			{
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.item = std::move(item);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+				// Another producer took it, position holds the new tail
+			}
+			else if (sequence < position)
+			{
+				// The consumer has not emptied this cell yet: full
+				return false;
+			}
+			else
+			{
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer side
+	bool pop(T& item)
+	{
+		size_t position = head.load(std::memory_order_relaxed);
+		Cell& cell = cells[position & (size - 1)];
+		if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+		{
+			// Empty, or the producer that claimed this cell is still writing it
+			return false;
+		}
+
+		item = std::move(cell.item);
+		cell.sequence.store(position + size, std::memory_order_release);
+		head.store(position + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T item;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t size;
+
+	char padding1[QUEUE_CACHE_LINE];
+	std::atomic<size_t> head; // Only the consumer moves it
+	char padding2[QUEUE_CACHE_LINE];
+	std::atomic<size_t> tail;
+	char padding3[QUEUE_CACHE_LINE];
+};
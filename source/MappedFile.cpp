@@ -0,0 +1,130 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(file, &length) || 0 == length.QuadPart)
+	{
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == mapping)
+	{
+		close();
+		return false;
+	}
+
+	data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (nullptr == data)
+	{
+		close();
+		return false;
+	}
+
+	size = size_t(length.QuadPart);
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	if (nullptr != data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (nullptr != mapping)
+	{
+		CloseHandle(mapping);
+	}
+	if (INVALID_HANDLE_VALUE != file)
+	{
+		CloseHandle(file);
+	}
+
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	int descriptor = ::open(fileName.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (0 != fstat(descriptor, &status) || 0 == status.st_size)
+	{
+		::close(descriptor);
+		return false;
+	}
+
+	// The mapping keeps its own reference to the file
+	void* view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+
+	if (MAP_FAILED == view)
+	{
+		return false;
+	}
+
+	data = static_cast<const unsigned char*>(view);
+	size = size_t(status.st_size);
+	return true;
+}
+
+void MappedFile::close(void)
+{
+	if (nullptr != data)
+	{
+		munmap(const_cast<unsigned char*>(data), size);
+	}
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
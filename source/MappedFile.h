@@ -0,0 +1,33 @@
+#pragma once
+#include "includes.h"
+
+// Read-only view of a whole file, memory-mapped so that lookups only touch
+// the pages they need and several processes share one copy of the data
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string& fileName);
+
+	void close(void);
+
+	bool isOpen(void) const { return nullptr != data; }
+
+	const unsigned char* getData(void) const { return data; }
+
+	size_t getSize(void) const { return size; }
+
+private:
+	const unsigned char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
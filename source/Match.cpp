@@ -0,0 +1,419 @@
+#include "Match.h"
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	// Used when no openings file is given. Short, balanced main lines
+	const char* DEFAULT_OPENINGS[] =
+	{
+		"E2-E4 E7-E5 G1-F3 B8-C6 F1-B5 A7-A6",
+		"E2-E4 E7-E5 G1-F3 B8-C6 F1-C4 F8-C5",
+		"E2-E4 C7-C5 G1-F3 D7-D6 D2-D4 C5-D4 F3-D4 G8-F6",
+		"E2-E4 C7-C5 B1-C3 B8-C6 G2-G3 G7-G6",
+		"E2-E4 E7-E6 D2-D4 D7-D5 B1-C3 G8-F6",
+		"E2-E4 C7-C6 D2-D4 D7-D5 E4-E5 C8-F5",
+		"E2-E4 D7-D5 E4-D5 D8-D5 B1-C3 D5-A5",
+		"E2-E4 G8-F6 E4-E5 F6-D5 D2-D4 D7-D6",
+		"D2-D4 D7-D5 C2-C4 E7-E6 B1-C3 G8-F6",
+		"D2-D4 D7-D5 C2-C4 C7-C6 G1-F3 G8-F6",
+		"D2-D4 G8-F6 C2-C4 G7-G6 B1-C3 F8-G7 E2-E4 D7-D6",
+		"D2-D4 G8-F6 C2-C4 E7-E6 B1-C3 F8-B4",
+		"D2-D4 G8-F6 C2-C4 C7-C5 D4-D5 B7-B5",
+		"D2-D4 F7-F5 G2-G3 G8-F6 F1-G2 E7-E6",
+		"C2-C4 E7-E5 B1-C3 G8-F6 G2-G3 D7-D5",
+		"G1-F3 D7-D5 G2-G3 G8-F6 F1-G2 C7-C6",
+	};
+
+	// Moves in saved game notation ("E2-E4") or UCI notation ("e2e4"), from the start position
+	std::vector<CompactMove> parseOpening(const std::string& line)
+	{
+		std::vector<CompactMove> moves;
+		Board board;
+		board.setStartPosition();
+
+		std::istringstream stream(line);
+		string token;
+		while (stream >> token)
+		{
+			CompactMove move = board.parseRecord(token);
+			if (move.isNull())
+			{
+				move = board.parseUci(token);
+			}
+			if (move.isNull())
+			{
+				throw invalid_argument("Illegal opening move " + token + " in: " + line + "\n");
+			}
+
+			moves.push_back(move);
+			board.makeMove(move);
+		}
+
+		return moves;
+	}
+}
+
+EngineConfig::EngineConfig()
+{
+	hashMb = TranspositionTable::DEFAULT_SIZE_MB;
+	depth = 0;
+	nodes = 0;
+}
+
+void EngineConfig::parse(const std::string& text)
+{
+	std::istringstream stream(text);
+	string option;
+
+	while (std::getline(stream, option, ','))
+	{
+		size_t separator = option.find('=');
+		if (string::npos == separator)
+		{
+			throw invalid_argument("Engine option must be key=value: " + option + "\n");
+		}
+
+		string key = option.substr(0, separator);
+		string value = option.substr(separator + 1);
+
+		try
+		{
+			if ("name" == key)       name = value;
+			else if ("hash" == key)  hashMb = std::stoul(value);
+			else if ("depth" == key) depth = std::stoi(value);
+			else if ("nodes" == key) nodes = std::stoull(value);
+			else if ("weights" == key)
+			{
+				Evaluation evaluation;
+				if (!evaluation.loadWeights(value))
+				{
+					throw invalid_argument("Error loading weights from " + value + "\n");
+				}
+				weightsFile = value;
+			}
+			else if ("book" == key)
+			{
+				OpeningBook book;
+				if (!book.open(value))
+				{
+					throw invalid_argument("Error loading book " + value + "\n");
+				}
+				bookFile = value;
+			}
+			else throw invalid_argument("Unknown engine option: " + key + "\n");
+		}
+		catch (std::logic_error&)
+		{
+			throw invalid_argument("Invalid value for engine option " + key + ": " + value + "\n");
+		}
+	}
+}
+
+Match::Settings::Settings()
+{
+	engines[0].name = "engine1";
+	engines[1].name = "engine2";
+
+	games = 100;
+	concurrency = std::max(1, int(std::thread::hardware_concurrency()));
+	baseTime = 10000;
+	increment = 100;
+	moveOverhead = TimeManager::DEFAULT_MOVE_OVERHEAD;
+	maxPlies = 400;
+
+	outputPrefix = "match_";
+
+	sprt = false;
+	elo0 = 0.0;
+	elo1 = 5.0;
+	alpha = 0.05;
+	beta = 0.05;
+}
+
+Match::Match(const Settings& settings)
+	: settings(settings)
+{
+	for (size_t i = 0; i < sizeof(DEFAULT_OPENINGS) / sizeof(DEFAULT_OPENINGS[0]); i++)
+	{
+		openings.push_back(parseOpening(DEFAULT_OPENINGS[i]));
+	}
+
+	nextGame.store(0);
+	stopRequested.store(false);
+	wins = draws = losses = finished = 0;
+}
+
+void Match::loadOpenings(const std::string& fileName)
+{
+	std::ifstream ifs(fileName);
+	if (!ifs)
+	{
+		throw invalid_argument("Error loading " + fileName + "\n");
+	}
+
+	std::vector<std::vector<CompactMove> > loaded;
+	string line;
+	while (std::getline(ifs, line))
+	{
+		// Same comment lines as the saved games
+		if (line.empty() || '[' == line[0] || '#' == line[0])
+		{
+			continue;
+		}
+		loaded.push_back(parseOpening(line));
+	}
+
+	if (loaded.empty())
+	{
+		throw invalid_argument("No openings in " + fileName + "\n");
+	}
+	openings.swap(loaded);
+}
+
+void Match::run(std::ostream& out)
+{
+	if (!settings.openingsFile.empty())
+	{
+		loadOpenings(settings.openingsFile);
+	}
+
+	out << "Playing " << settings.games << " games of " << settings.engines[0].name << " vs " << settings.engines[1].name
+		<< " on " << settings.concurrency << " threads, " << openings.size() << " openings" << endl;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < settings.concurrency; i++)
+	{
+		threads.push_back(std::thread(&Match::worker, this, std::ref(out)));
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	double score = finished > 0 ? (wins + 0.5 * draws) / finished : 0.5;
+	out << "===========================\n";
+	out << "Games           : " << finished << "\n";
+	out << "Score of " << settings.engines[0].name << " vs " << settings.engines[1].name << ": "
+		<< wins << " - " << losses << " - " << draws << "\n";
+	out << "Elo difference  : " << std::fixed << std::setprecision(1) << Sprt::scoreToElo(score) << endl;
+}
+
+void Match::worker(std::ostream& out)
+{
+	// Every thread keeps its own pair of engines, so games never share a table
+	Player players[2];
+	for (int i = 0; i < 2; i++)
+	{
+		players[i].table.reset(new TranspositionTable(settings.engines[i].hashMb));
+		players[i].search.reset(new Search(*players[i].table));
+		players[i].search->getTimeManager().setMoveOverhead(settings.moveOverhead);
+		if (!settings.engines[i].weightsFile.empty())
+		{
+			players[i].search->getEvaluation().loadWeights(settings.engines[i].weightsFile);
+		}
+		if (!settings.engines[i].bookFile.empty())
+		{
+			players[i].book.open(settings.engines[i].bookFile);
+		}
+	}
+
+	while (!stopRequested.load())
+	{
+		int index = nextGame.fetch_add(1);
+		if (index >= settings.games)
+		{
+			break;
+		}
+
+		GameResult result = playGame(index, players);
+		int white = index % 2;
+
+		saveGame(index, white, result);
+		report(out, index, white, result);
+	}
+}
+
+Match::GameResult Match::playGame(int index, Player players[2])
+{
+	GameResult result;
+
+	// Both colors of an opening are played back to back
+	int engineOf[2];
+	engineOf[Chess::WHITE_PLAYER] = index % 2;
+	engineOf[Chess::BLACK_PLAYER] = 1 - index % 2;
+
+	// Book choices depend only on the game number, so a match can be replayed
+	for (int i = 0; i < 2; i++)
+	{
+		players[i].table->clear();
+		players[i].random.seed(uint32_t(index));
+	}
+
+	Board board;
+	board.setStartPosition();
+	std::vector<uint64_t> history;
+
+	const std::vector<CompactMove>& opening = openings[(index / 2) % openings.size()];
+	for (size_t i = 0; i < opening.size(); i++)
+	{
+		addRecord(result.rounds, board.sideToMove, board.toRecord(opening[i]));
+		history.push_back(board.hash);
+		board.makeMove(opening[i]);
+	}
+
+	int clock[2] = { settings.baseTime, settings.baseTime };
+
+	while (true)
+	{
+		Chess::TerminalState state = board.terminalState(history);
+		if (Chess::CHECKMATE == state)
+		{
+			result.whiteScore = Chess::WHITE_PLAYER == board.sideToMove ? 0.0 : 1.0;
+			result.reason = Chess::describeTerminalState(state);
+			break;
+		}
+		if (Chess::ONGOING != state)
+		{
+			result.whiteScore = 0.5;
+			result.reason = Chess::describeTerminalState(state);
+			break;
+		}
+		if (int(history.size()) >= settings.maxPlies)
+		{
+			result.whiteScore = 0.5;
+			result.reason = "move limit";
+			break;
+		}
+
+		int side = board.sideToMove;
+		const EngineConfig& config = settings.engines[engineOf[side]];
+		Player& player = players[engineOf[side]];
+
+		SearchLimits limits;
+		limits.depth = config.depth;
+		limits.nodes = config.nodes;
+		if (settings.baseTime > 0)
+		{
+			for (int color = 0; color < 2; color++)
+			{
+				limits.time[color] = std::max(clock[color], 1);
+				limits.increment[color] = settings.increment;
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		CompactMove move = player.book.pick(board, player.random());
+		if (move.isNull())
+		{
+			move = player.search->think(board, limits, history).bestMove;
+		}
+		int elapsed = int(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+
+		if (settings.baseTime > 0)
+		{
+			clock[side] -= elapsed;
+			if (clock[side] < 0)
+			{
+				result.whiteScore = Chess::WHITE_PLAYER == side ? 0.0 : 1.0;
+				result.reason = "loss on time";
+				break;
+			}
+			clock[side] += settings.increment;
+		}
+
+		addRecord(result.rounds, side, board.toRecord(move));
+		history.push_back(board.hash);
+		board.makeMove(move);
+	}
+
+	return result;
+}
+
+void Match::report(std::ostream& out, int index, int white, const GameResult& result)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// The first engine's score
+	double score = 0 == white ? result.whiteScore : 1.0 - result.whiteScore;
+	if (1.0 == score)      wins++;
+	else if (0.0 == score) losses++;
+	else                   draws++;
+	finished++;
+
+	out << "Finished game " << index + 1 << " (" << settings.engines[white].name << " vs " << settings.engines[1 - white].name << "): "
+		<< resultText(result.whiteScore) << " {" << result.reason << "}\n";
+	out << "Score of " << settings.engines[0].name << " vs " << settings.engines[1].name << ": "
+		<< wins << " - " << losses << " - " << draws << "  [" << std::fixed << std::setprecision(3)
+		<< (wins + 0.5 * draws) / finished << "] " << finished << "\n";
+
+	if (settings.sprt)
+	{
+		Sprt sprt(settings.elo0, settings.elo1, settings.alpha, settings.beta);
+		Sprt::Decision decision = sprt.decide(wins, draws, losses);
+
+		out << "LLR: " << std::setprecision(2) << sprt.llr(wins, draws, losses)
+			<< " (" << sprt.getLowerBound() << ", " << sprt.getUpperBound() << ")"
+			<< " [" << settings.elo0 << ", " << settings.elo1 << "]\n";
+
+		// Games already running are still counted, no new ones are started
+		if (Sprt::CONTINUE != decision && !stopRequested.exchange(true))
+		{
+			out << "SPRT: " << (Sprt::ACCEPT_H1 == decision ? "H1" : "H0") << " was accepted\n";
+		}
+	}
+
+	out << std::flush;
+}
+
+void Match::saveGame(int index, int white, const GameResult& result) const
+{
+	if (settings.outputPrefix.empty())
+	{
+		return;
+	}
+
+	std::ostringstream fileName;
+	fileName << settings.outputPrefix << std::setw(4) << std::setfill('0') << index + 1 << ".dat";
+
+	std::ofstream ofs(fileName.str());
+	if (!ofs.is_open())
+	{
+		return;
+	}
+
+	// The loader skips lines that start with "[", so the tags don't get in its way
+	ofs << "[White] " << settings.engines[white].name << "\n";
+	ofs << "[Black] " << settings.engines[1 - white].name << "\n";
+	ofs << "[Result] " << resultText(result.whiteScore) << " {" << result.reason << "}\n";
+	Game::saveRounds(ofs, result.rounds);
+}
+
+void Match::addRecord(std::deque<Game::Round>& rounds, int color, std::string record)
+{
+	// Same padding and layout as Game::getRecord and Game::save
+	if (record.length() == 5)
+	{
+		record += "  ";
+	}
+
+	if (Chess::WHITE_PLAYER == color)
+	{
+		Game::Round round;
+		round.whiteMove = record;
+		rounds.push_back(round);
+	}
+	else
+	{
+		rounds.back().blackMove = record;
+	}
+}
+
+std::string Match::resultText(double whiteScore)
+{
+	if (1.0 == whiteScore)
+	{
+		return "1-0";
+	}
+	return 0.0 == whiteScore ? "0-1" : "1/2-1/2";
+}
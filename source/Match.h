@@ -0,0 +1,103 @@
+#pragma once
+#include "includes.h"
+#include "Search.h"
+#include "OpeningBook.h"
+#include "Sprt.h"
+#include "game.h"
+#include <atomic>
+#include <mutex>
+#include <random>
+
+// Settings of one side of a match, parsed from "name=dev,hash=32,depth=8,weights=tuned.txt,book=book.bin"
+struct EngineConfig
+{
+	std::string name;
+	size_t      hashMb;
+	int         depth;       // 0 means no depth limit
+	uint64_t    nodes;       // 0 means no node limit
+	std::string weightsFile; // Evaluation weights, empty for the built-in ones
+	std::string bookFile;    // Opening book played from before searching, empty for none
+
+	EngineConfig();
+
+	// Throws invalid_argument on an unknown key, a bad value or a file that can't be loaded
+	void parse(const std::string& text);
+};
+
+// Plays engine-vs-engine games on a pool of threads. Every opening is played
+// twice with the colors swapped, each game is written as a .dat file that the
+// console game can load, and the match stops early once the SPRT is decided
+class Match
+{
+public:
+	struct Settings
+	{
+		EngineConfig engines[2];
+
+		int games;
+		int concurrency;
+		int baseTime;     // Milliseconds on each clock at the start, 0 for no clock
+		int increment;    // Milliseconds added after each move
+		int moveOverhead;
+		int maxPlies;     // Games this long are adjudicated as draws
+
+		std::string openingsFile; // One opening per line, empty for the built-in suite
+		std::string outputPrefix; // Games are saved as <prefix>0001.dat, ... Empty to skip
+
+		bool   sprt;
+		double elo0;
+		double elo1;
+		double alpha;
+		double beta;
+
+		Settings();
+	};
+
+	explicit Match(const Settings& settings);
+
+	// Throws invalid_argument if a line is not a legal move sequence
+	void loadOpenings(const std::string& fileName);
+
+	void run(std::ostream& out);
+
+private:
+	struct Player
+	{
+		std::unique_ptr<TranspositionTable> table;
+		std::unique_ptr<Search> search;
+		OpeningBook book;
+		std::mt19937 random;
+	};
+
+	struct GameResult
+	{
+		double whiteScore; // 1, 0.5 or 0
+		std::string reason;
+		std::deque<Game::Round> rounds;
+	};
+
+	Settings settings;
+	std::vector<std::vector<CompactMove> > openings;
+
+	std::atomic<int>  nextGame;
+	std::atomic<bool> stopRequested;
+
+	// Results from the point of view of the first engine
+	std::mutex mutex;
+	int wins;
+	int draws;
+	int losses;
+	int finished;
+
+	void worker(std::ostream& out);
+
+	GameResult playGame(int index, Player players[2]);
+
+	void report(std::ostream& out, int index, int white, const GameResult& result);
+
+	void saveGame(int index, int white, const GameResult& result) const;
+
+	static void addRecord(std::deque<Game::Round>& rounds, int color, std::string record);
+
+	static std::string resultText(double whiteScore);
+};
@@ -0,0 +1,258 @@
+#include "MateSolver.h"
+#include <algorithm>
+
+namespace
+{
+	uint32_t saturatedSum(uint64_t a, uint64_t b, uint32_t limit)
+	{
+		return uint32_t(std::min<uint64_t>(a + b, limit));
+	}
+}
+
+MateSolver::MateSolver(size_t megabytes)
+	: mask(0), nodes(0), nodeLimit(0), aborted(false)
+{
+	size_t count = 1;
+	while (count * 2 * sizeof(Entry) <= std::max<size_t>(megabytes, 1) * 1024 * 1024)
+	{
+		count *= 2;
+	}
+	table.resize(count);
+	mask = count - 1;
+	clear();
+}
+
+void MateSolver::clear(void)
+{
+	Entry empty = { 0, 0, 0, 0, -1 };
+	std::fill(table.begin(), table.end(), empty);
+}
+
+MateSolver::Result MateSolver::solve(const Board& board, int maxMoves, uint64_t limit)
+{
+	auto start = std::chrono::steady_clock::now();
+	Result result;
+	result.mateIn = 0;
+	result.unknown = false;
+
+	nodes = 0;
+	nodeLimit = limit;
+	aborted = false;
+
+	// Mate in 1 first, so the first mate found is the shortest
+	for (int moves = 1; moves <= maxMoves; moves++)
+	{
+		int depth = 2 * moves - 1;
+		uint32_t pn;
+		uint32_t dn;
+		evaluate(board, depth, pn, dn);
+		if (0 != pn && 0 != dn)
+		{
+			search(board, depth, INFINITE_NUMBER, INFINITE_NUMBER, pn, dn);
+		}
+
+		if (aborted)
+		{
+			result.unknown = true;
+			break;
+		}
+		if (0 == pn)
+		{
+			result.mateIn = moves;
+			extractPv(board, depth, result.pv);
+			break;
+		}
+	}
+
+	result.nodes = nodes;
+	result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+void MateSolver::search(const Board& board, int depth, uint32_t thresholdPn, uint32_t thresholdDn, uint32_t& pn, uint32_t& dn)
+{
+	uint64_t startNodes = nodes++;
+	bool attacker = isAttacker(depth);
+
+	std::vector<Child> children;
+	Board::MoveList list;
+	board.generateLegalMoves(list);
+	children.resize(list.count);
+	for (int i = 0; i < list.count; i++)
+	{
+		Child& child = children[i];
+		child.board = board;
+		child.board.makeMove(list.moves[i]);
+		child.move = list.moves[i];
+		evaluate(child.board, depth - 1, child.pn, child.dn);
+	}
+
+	while (true)
+	{
+		// The attacker needs one proven move, the defender all of them
+		size_t best = 0;
+		uint32_t minimum = UINT32_MAX;
+		uint32_t second = INFINITE_NUMBER;
+		uint64_t sum = 0;
+		for (size_t i = 0; i < children.size(); i++)
+		{
+			uint32_t value = attacker ? children[i].pn : children[i].dn;
+			sum = std::min<uint64_t>(sum + (attacker ? children[i].dn : children[i].pn), INFINITE_NUMBER);
+
+			if (value < minimum)
+			{
+				second = std::min(minimum, uint32_t(INFINITE_NUMBER));
+				minimum = value;
+				best = i;
+			}
+			else if (value < second)
+			{
+				second = value;
+			}
+		}
+
+		pn = attacker ? minimum : uint32_t(sum);
+		dn = attacker ? uint32_t(sum) : minimum;
+
+		if (pn >= thresholdPn || dn >= thresholdDn || aborted)
+		{
+			break;
+		}
+
+		if (0 != nodeLimit && nodes >= nodeLimit)
+		{
+			aborted = true;
+			break;
+		}
+
+		// Search the best child until it gets worse than the second best
+		Child& child = children[best];
+		uint32_t childPn;
+		uint32_t childDn;
+		if (attacker)
+		{
+			childPn = std::min(thresholdPn, saturatedSum(second, 1, INFINITE_NUMBER));
+			childDn = thresholdDn >= INFINITE_NUMBER ? INFINITE_NUMBER : saturatedSum(thresholdDn - dn, child.dn, INFINITE_NUMBER);
+		}
+		else
+		{
+			childDn = std::min(thresholdDn, saturatedSum(second, 1, INFINITE_NUMBER));
+			childPn = thresholdPn >= INFINITE_NUMBER ? INFINITE_NUMBER : saturatedSum(thresholdPn - pn, child.pn, INFINITE_NUMBER);
+		}
+		search(child.board, depth - 1, childPn, childDn, child.pn, child.dn);
+	}
+
+	store(board.hash, depth, pn, dn, nodes - startNodes);
+}
+
+void MateSolver::evaluate(const Board& board, int depth, uint32_t& pn, uint32_t& dn) const
+{
+	if (lookup(board.hash, depth, pn, dn))
+	{
+		return;
+	}
+
+	// The attacker's last move has to give check
+	if (0 == depth && !board.isInCheck())
+	{
+		pn = INFINITE_NUMBER;
+		dn = 0;
+		return;
+	}
+
+	Board::MoveList list;
+	board.generateLegalMoves(list);
+	if (0 == list.count)
+	{
+		// Mated defender, or a stalemate or mated attacker
+		bool mate = !isAttacker(depth) && board.isInCheck();
+		pn = mate ? 0 : INFINITE_NUMBER;
+		dn = mate ? INFINITE_NUMBER : 0;
+	}
+	else if (0 == depth)
+	{
+		pn = INFINITE_NUMBER;
+		dn = 0;
+	}
+	else if (isAttacker(depth))
+	{
+		pn = 1;
+		dn = uint32_t(list.count);
+	}
+	else
+	{
+		// Fewer replies are easier to refute
+		pn = uint32_t(list.count);
+		dn = 1;
+	}
+}
+
+bool MateSolver::lookup(uint64_t key, int depth, uint32_t& pn, uint32_t& dn) const
+{
+	const Entry& entry = table[key & mask];
+	if (entry.key != key || entry.depth < 0)
+	{
+		return false;
+	}
+
+	// A mate found with fewer plies left is still a mate, and no mate with
+	// more plies left means none with fewer
+	if ((0 == entry.pn && entry.depth <= depth) || (0 == entry.dn && entry.depth >= depth) || entry.depth == depth)
+	{
+		pn = entry.pn;
+		dn = entry.dn;
+		return true;
+	}
+	return false;
+}
+
+void MateSolver::store(uint64_t key, int depth, uint32_t pn, uint32_t dn, uint64_t work)
+{
+	Entry& entry = table[key & mask];
+	uint32_t newWork = uint32_t(std::min<uint64_t>(work, UINT32_MAX));
+
+	// Results that took more work to find are kept
+	if (entry.key == key || entry.work <= newWork)
+	{
+		entry.key = key;
+		entry.pn = pn;
+		entry.dn = dn;
+		entry.work = newWork;
+		entry.depth = depth;
+	}
+}
+
+void MateSolver::extractPv(const Board& board, int depth, std::vector<CompactMove>& pv) const
+{
+	Board position = board;
+
+	while (depth > 0)
+	{
+		Board::MoveList list;
+		position.generateLegalMoves(list);
+
+		bool found = false;
+		for (int i = 0; i < list.count && !found; i++)
+		{
+			Board child = position;
+			child.makeMove(list.moves[i]);
+
+			uint32_t pn;
+			uint32_t dn;
+			evaluate(child, depth - 1, pn, dn);
+			if (0 == pn)
+			{
+				pv.push_back(list.moves[i]);
+				position = child;
+				found = true;
+			}
+		}
+
+		// The line stops where the table no longer has the proof
+		if (!found)
+		{
+			break;
+		}
+		depth--;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+
+// Finds forced mates with depth-first proof-number search (df-pn). Instead of
+// a score every position keeps two numbers: how many more positions have to
+// be proven to show that the attacker mates (pn), and how many to show that
+// there is no mate (dn). The search always expands the position that is cheapest
+// to settle, so it goes straight down forcing lines and skips the quiet moves
+// alpha-beta would have to look at. Mates are searched for the side to move
+class MateSolver
+{
+public:
+	static const size_t DEFAULT_HASH_MB = 64;
+
+	struct Result
+	{
+		int      mateIn;  // Moves of the attacker, 0 when no mate was found
+		bool     unknown; // The node limit was reached before the search was over
+		std::vector<CompactMove> pv;
+		uint64_t nodes;
+		long long elapsed;
+	};
+
+	explicit MateSolver(size_t megabytes = DEFAULT_HASH_MB);
+
+	void clear(void);
+
+	// Shortest mate in at most maxMoves moves. nodeLimit 0 means no limit
+	Result solve(const Board& board, int maxMoves, uint64_t nodeLimit = 0);
+
+private:
+	static const uint32_t INFINITE_NUMBER = 0x3FFFFFFF;
+
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t pn;
+		uint32_t dn;
+		uint32_t work;  // Nodes spent on it, the bigger one is kept
+		int32_t  depth; // Plies left to mate in
+	};
+
+	struct Child
+	{
+		Board       board;
+		CompactMove move;
+		uint32_t    pn;
+		uint32_t    dn;
+	};
+
+	std::vector<Entry> table;
+	size_t mask;
+
+	uint64_t nodes;
+	uint64_t nodeLimit;
+	bool aborted;
+
+	// The attacker moves when an odd number of plies is left, the defender when it is even
+	static bool isAttacker(int depth) { return 1 == (depth & 1); }
+
+	void search(const Board& board, int depth, uint32_t thresholdPn, uint32_t thresholdDn, uint32_t& pn, uint32_t& dn);
+
+	// Numbers of a position from the table, or a first guess from its mobility
+	void evaluate(const Board& board, int depth, uint32_t& pn, uint32_t& dn) const;
+
+	bool lookup(uint64_t key, int depth, uint32_t& pn, uint32_t& dn) const;
+
+	void store(uint64_t key, int depth, uint32_t pn, uint32_t dn, uint64_t work);
+
+	void extractPv(const Board& board, int depth, std::vector<CompactMove>& pv) const;
+};
@@ -1,7 +1,10 @@
 #include "Move.h"
+#include "AllocationTracker.h"
 
 Move::Move()
 {
+	CHESS_ALLOC_SCOPE(MOVE);
+
 	present = { 0 };
 	future = { 0 };
 	enPassant = new Chess::EnPassant;
@@ -59,5 +62,6 @@ void Move::setCastling(Chess::Castling* castling)
 
 void Move::setPromotion(Chess::Promotion* promotion)
 {
-	this->promotion = promotion;
+	// Callers pass a local, so keep a copy rather than the pointer
+	*this->promotion = *promotion;
 }
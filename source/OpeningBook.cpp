@@ -0,0 +1,159 @@
+#include "OpeningBook.h"
+#include <algorithm>
+
+namespace
+{
+	const char PROMOTIONS[] = { 0, Chess::PIECE_TYPE_KNIGHT, Chess::PIECE_TYPE_BISHOP, Chess::PIECE_TYPE_ROOK, Chess::PIECE_TYPE_QUEEN };
+
+	uint64_t readBigEndian(const unsigned char* data, int bytes)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; i++)
+		{
+			value = (value << 8) | data[i];
+		}
+		return value;
+	}
+}
+
+bool OpeningBook::open(const std::string& fileName)
+{
+	if (!file.open(fileName))
+	{
+		return false;
+	}
+
+	if (0 != file.getSize() % ENTRY_SIZE)
+	{
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+uint64_t OpeningBook::keyAt(size_t index) const
+{
+	return readBigEndian(file.getData() + index * ENTRY_SIZE, 8);
+}
+
+std::vector<OpeningBook::Entry> OpeningBook::probe(const Board& board) const
+{
+	std::vector<Entry> entries;
+	if (!isOpen())
+	{
+		return entries;
+	}
+
+	// First entry with this key
+	size_t low = 0;
+	size_t high = size();
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (keyAt(middle) < board.hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	for (size_t i = low; i < size() && keyAt(i) == board.hash; i++)
+	{
+		const unsigned char* data = file.getData() + i * ENTRY_SIZE;
+
+		// A move that is not legal here means the key collided with another position
+		Entry entry;
+		entry.move = decodeMove(board, uint16_t(readBigEndian(data + 8, 2)));
+		entry.weight = uint16_t(readBigEndian(data + 10, 2));
+		if (!entry.move.isNull() && entry.weight > 0)
+		{
+			entries.push_back(entry);
+		}
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.weight > b.weight; });
+	return entries;
+}
+
+CompactMove OpeningBook::pick(const Board& board, uint32_t random) const
+{
+	std::vector<Entry> entries = probe(board);
+
+	uint32_t total = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		total += entries[i].weight;
+	}
+	if (0 == total)
+	{
+		return CompactMove::null();
+	}
+
+	uint32_t choice = random % total;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (choice < entries[i].weight)
+		{
+			return entries[i].move;
+		}
+		choice -= entries[i].weight;
+	}
+	return entries.back().move;
+}
+
+uint16_t OpeningBook::encodeMove(const CompactMove& move)
+{
+	int to = move.to;
+	if (move.flags & CompactMove::FLAG_CASTLING)
+	{
+		// The rook's square: H file for the king side, A file for the queen side
+		to = Board::makeSquare(Board::rowOf(move.to), Board::columnOf(move.to) > 4 ? 7 : 0);
+	}
+
+	int promotion = 0;
+	for (int i = 1; i < 5; i++)
+	{
+		if (PROMOTIONS[i] == move.promotion)
+		{
+			promotion = i;
+		}
+	}
+
+	return uint16_t(to | (move.from << 6) | (promotion << 12));
+}
+
+CompactMove OpeningBook::decodeMove(const Board& board, uint16_t data)
+{
+	int to = data & 0x3F;
+	int from = (data >> 6) & 0x3F;
+	int promotion = (data >> 12) & 0x7;
+
+	if (promotion > 4)
+	{
+		return CompactMove::null();
+	}
+
+	// Back from "king takes rook" to the king's real destination
+	char piece = board.getPiece(from);
+	if (Chess::PIECE_TYPE_KING == (piece & ~0x20) && Board::rowOf(from) == Board::rowOf(to) && 4 == Board::columnOf(from) &&
+		(0 == Board::columnOf(to) || 7 == Board::columnOf(to)))
+	{
+		to = Board::makeSquare(Board::rowOf(to), 0 == Board::columnOf(to) ? 2 : 6);
+	}
+
+	Board::MoveList list;
+	board.generateLegalMoves(list);
+	for (int i = 0; i < list.count; i++)
+	{
+		const CompactMove& move = list.moves[i];
+		if (move.from == from && move.to == to && move.promotion == PROMOTIONS[promotion])
+		{
+			return move;
+		}
+	}
+
+	return CompactMove::null();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+#include "MappedFile.h"
+
+// Opening book in the Polyglot .bin layout: 16 byte big-endian entries
+// (key, move, weight, learn) sorted by key. The file is memory-mapped and
+// searched in place, so opening a book costs nothing and a probe is a
+// binary search over a few pages.
+// Keys are the Board hash keys, which are the Polyglot ones (its layout and
+// its Random64 numbers), so books made by other Polyglot tools work too;
+// "chess_book verify" checks them against the keys the format publishes
+class OpeningBook
+{
+public:
+	struct Entry
+	{
+		CompactMove move;
+		uint16_t    weight;
+	};
+
+	static const size_t ENTRY_SIZE = 16;
+
+	// A file that is not a whole number of entries is not a book, and is left closed
+	bool open(const std::string& fileName);
+
+	void close(void) { file.close(); }
+
+	bool isOpen(void) const { return file.isOpen(); }
+
+	size_t size(void) const { return file.getSize() / ENTRY_SIZE; }
+
+	// Legal book moves for the position, heaviest first
+	std::vector<Entry> probe(const Board& board) const;
+
+	// A book move chosen with probability proportional to its weight,
+	// or a null move when the position is not in the book
+	CompactMove pick(const Board& board, uint32_t random) const;
+
+	// Polyglot move: to square in bits 0-5, from square in bits 6-11, promotion in 12-14.
+	// Castling is written as the king taking its own rook
+	static uint16_t encodeMove(const CompactMove& move);
+
+	static CompactMove decodeMove(const Board& board, uint16_t data);
+
+private:
+	MappedFile file;
+
+	uint64_t keyAt(size_t index) const;
+};
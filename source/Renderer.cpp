@@ -0,0 +1,410 @@
+#include "Renderer.h"
+#include "user_interface.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Big enough for a full frame with the default cell size, so it is allocated only once
+	const size_t FRAME_RESERVE = 8 * 1024;
+
+	const char* const LOGO =
+		"    ======================================\n"
+		"       _____ _    _ ______  _____ _____\n"
+		"      / ____| |  | |  ____|/ ____/ ____|\n"
+		"     | |    | |__| | |__  | (___| (___ \n"
+		"     | |    |  __  |  __|  \\___ \\\\___ \\ \n"
+		"     | |____| |  | | |____ ____) |___) |\n"
+		"      \\____|_|  |_|______|_____/_____/\n\n"
+		"    ======================================\n\n";
+}
+
+Renderer::Renderer()
+{
+	frame.reserve(FRAME_RESERVE);
+	situationCount = 0;
+	differential = false;
+	drawn = false;
+
+#ifdef _WIN32
+	// The ANSI sequences have to be switched on for the Windows console
+	HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode = 0;
+	if (GetConsoleMode(output, &mode))
+	{
+		SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	}
+#endif
+}
+
+Renderer::~Renderer()
+{
+	if (drawn)
+	{
+		frame.clear();
+		appendReleaseFrame();
+		flush();
+	}
+}
+
+void Renderer::setDifferential(bool enabled)
+{
+	differential = enabled;
+}
+
+void Renderer::drawLogo(bool clear)
+{
+	frame.clear();
+	if (clear)
+	{
+		appendClear();
+	}
+	appendLogo();
+	flush();
+}
+
+void Renderer::drawGame(Game& game, bool clear)
+{
+	CHESS_TRACE_SPAN("render");
+
+	frame.clear();
+
+	// The fixed layout only works if the whole frame stays on screen
+	int rows = terminalRows();
+	if (differential && (0 == rows || rows >= FRAME_LINES + MIN_ROWS_BELOW))
+	{
+		if (drawn)
+		{
+			appendChanges(game);
+		}
+		else
+		{
+			appendFixedFrame(game);
+		}
+		flush();
+		return;
+	}
+
+	if (clear || drawn)
+	{
+		appendClear();
+	}
+	appendLogo();
+	appendSituation(game);
+	appendBoard(game);
+	flush();
+}
+
+void Renderer::appendClear(void)
+{
+	if (drawn)
+	{
+		appendReleaseFrame();
+	}
+
+	// Cursor home, then erase the screen
+	frame += "\x1b[H\x1b[2J";
+}
+
+void Renderer::appendLogo(void)
+{
+	frame += LOGO;
+}
+
+void Renderer::appendSituation(Game& game)
+{
+	buildSituation(game, false);
+	for (size_t i = 0; i < situationCount; i++)
+	{
+		frame += situation[i];
+		frame += '\n';
+	}
+}
+
+void Renderer::buildSituation(Game& game, bool padded)
+{
+	situationCount = 0;
+
+	// Last moves - print only if at least one move has been made
+	size_t plies = game.getPlyCount();
+	if (0 != plies)
+	{
+		nextSituationLine() = "Last moves:";
+
+		int moves = int((plies + 1) / 2);
+		int toShow = moves >= 5 ? 5 : moves;
+
+		while (toShow--)
+		{
+			std::string& line = nextSituationLine();
+
+			// An extra space aligns the numbers that are smaller than 10
+			if (moves < 10)
+			{
+				line += ' ';
+			}
+
+			size_t white = 2 * size_t(moves - 1);
+			line += std::to_string(moves);
+			line += " ..... ";
+			line += game.getRecord(white);
+			line += " | ";
+			if (white + 1 < plies)
+			{
+				line += game.getRecord(white + 1);
+			}
+			moves--;
+		}
+
+		nextSituationLine();
+	}
+	while (padded && situationCount < 7)
+	{
+		nextSituationLine();
+	}
+
+	// Captured pieces - print only if at least one piece has been captured
+	const std::vector<char>& whiteCaptured = game.getCaptured(Chess::WHITE_PIECE);
+	const std::vector<char>& blackCaptured = game.getCaptured(Chess::BLACK_PIECE);
+	if (0 != whiteCaptured.size() || 0 != blackCaptured.size())
+	{
+		nextSituationLine() = "---------------------------------------------";
+
+		std::string& white = nextSituationLine();
+		white = "WHITE captured: ";
+		for (size_t i = 0; i < whiteCaptured.size(); i++)
+		{
+			white += whiteCaptured[i];
+			white += ' ';
+		}
+
+		std::string& black = nextSituationLine();
+		black = "black captured: ";
+		for (size_t i = 0; i < blackCaptured.size(); i++)
+		{
+			black += blackCaptured[i];
+			black += ' ';
+		}
+
+		nextSituationLine() = "---------------------------------------------";
+	}
+	while (padded && situationCount < 11)
+	{
+		nextSituationLine();
+	}
+
+	std::string& turn = nextSituationLine();
+	turn = "Current turn: ";
+	turn += game.getCurrentTurn() == Chess::WHITE_PIECE ? "WHITE (upper case)" : "BLACK (lower case)";
+	nextSituationLine();
+}
+
+std::string& Renderer::nextSituationLine(void)
+{
+	// The strings are kept, so their memory is reused by the next frame
+	if (situationCount == situation.size())
+	{
+		situation.push_back(std::string());
+	}
+
+	std::string& line = situation[situationCount++];
+	line.clear();
+	return line;
+}
+
+void Renderer::appendBoard(Game& game)
+{
+	frame += "   A     B     C     D     E     F     G     H\n\n";
+
+	for (int line = 7; line >= 0; line--)
+	{
+		// Even lines start with a black square
+		if (line % 2 == 0)
+		{
+			appendLine(game, line, char(BLACK_SQUARE), char(WHITE_SQUARE));
+		}
+		else
+		{
+			appendLine(game, line, char(WHITE_SQUARE), char(BLACK_SQUARE));
+		}
+	}
+}
+
+void Renderer::appendLine(Game& game, int line, char color1, char color2)
+{
+	// A square is CELL characters wide and CELL / 2 sub-lines high, since a
+	// character is about twice as high as it is wide. The piece goes in the
+	// middle of the second sub-line
+	for (int subLine = 0; subLine < CELL / 2; subLine++)
+	{
+		for (int column = 0; column < 8; column++)
+		{
+			char color = 0 == column % 2 ? color1 : color2;
+			if (1 == subLine)
+			{
+				char piece = game.getPieceAtPosition(line, column);
+				frame.append(CELL / 2, color);
+				frame += EMPTY_SQUARE != piece ? piece : color;
+				frame.append(CELL - CELL / 2 - 1, color);
+			}
+			else
+			{
+				frame.append(CELL, color);
+			}
+		}
+
+		// The number of the line on the right
+		if (1 == subLine)
+		{
+			frame += "   ";
+			frame += char('1' + line);
+		}
+		frame += '\n';
+	}
+}
+
+void Renderer::appendFixedFrame(Game& game)
+{
+	appendClear();
+	appendLogo();
+
+	buildSituation(game, true);
+	for (size_t i = 0; i < situationCount; i++)
+	{
+		frame += situation[i];
+		frame += '\n';
+	}
+	shownSituation.assign(situation.begin(), situation.begin() + situationCount);
+
+	appendBoard(game);
+	for (int line = 0; line < 8; line++)
+	{
+		for (int column = 0; column < 8; column++)
+		{
+			shownBoard[line][column] = game.getPieceAtPosition(line, column);
+		}
+	}
+
+	// Only the lines below the frame scroll from now on. Setting the
+	// scrolling region moves the cursor home, so it is moved back down after
+	frame += "\x1b[" + std::to_string(FRAME_LINES + 1) + "r";
+	appendMoveTo(FRAME_LINES + 1, 1);
+	drawn = true;
+}
+
+void Renderer::appendChanges(Game& game)
+{
+	buildSituation(game, true);
+	for (size_t i = 0; i < situationCount; i++)
+	{
+		if (situation[i] != shownSituation[i])
+		{
+			// Write the new text and erase what is left of the old one
+			appendMoveTo(LOGO_LINES + int(i) + 1, 1);
+			frame += situation[i];
+			frame += "\x1b[K";
+			shownSituation[i] = situation[i];
+		}
+	}
+
+	// Square colors never change, only the character in the middle of the square
+	for (int line = 0; line < 8; line++)
+	{
+		for (int column = 0; column < 8; column++)
+		{
+			char piece = game.getPieceAtPosition(line, column);
+			if (piece != shownBoard[line][column])
+			{
+				char color = 0 == (line + column) % 2 ? char(BLACK_SQUARE) : char(WHITE_SQUARE);
+				appendMoveTo(BOARD_TOP + (7 - line) * (CELL / 2) + 2, column * CELL + CELL / 2 + 1);
+				frame += EMPTY_SQUARE != piece ? piece : color;
+				shownBoard[line][column] = piece;
+			}
+		}
+	}
+
+	// The old messages and prompts below the frame go away
+	appendMoveTo(FRAME_LINES + 1, 1);
+	frame += "\x1b[J";
+}
+
+void Renderer::appendMoveTo(int row, int column)
+{
+	frame += "\x1b[";
+	frame += std::to_string(row);
+	frame += ';';
+	frame += std::to_string(column);
+	frame += 'H';
+}
+
+void Renderer::appendReleaseFrame(void)
+{
+	// Scrolling region back to the whole window, cursor to its last line
+	frame += "\x1b[r\x1b[999;1H\n";
+	drawn = false;
+}
+
+int Renderer::terminalRows(void)
+{
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+	{
+		return info.srWindow.Bottom - info.srWindow.Top + 1;
+	}
+#else
+	struct winsize size;
+	if (0 == ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) && size.ws_row > 0)
+	{
+		return size.ws_row;
+	}
+#endif
+	return 0;
+}
+
+void Renderer::flush(void)
+{
+	cout.flush();
+	fflush(stdout);
+
+	const char* data = frame.data();
+	size_t left = frame.size();
+
+#ifdef _WIN32
+	HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+	while (left > 0)
+	{
+		DWORD written = 0;
+		if (!WriteFile(output, data, DWORD(left), &written, NULL) || 0 == written)
+		{
+			break;
+		}
+		data += written;
+		left -= written;
+	}
+#else
+	// A pipe or a terminal may take only part of it
+	while (left > 0)
+	{
+		ssize_t written = ::write(STDOUT_FILENO, data, left);
+		if (written < 0 && EINTR == errno)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			break;
+		}
+		data += written;
+		left -= size_t(written);
+	}
+#endif
+}
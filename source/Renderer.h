@@ -0,0 +1,76 @@
+#pragma once
+#include "includes.h"
+#include "game.h"
+
+// Draws the console screen. The whole frame (logo, last moves, captures and
+// board) is built in one buffer that is reused between frames and goes out
+// with a single write, and the screen is cleared with an ANSI sequence
+// instead of running "cls". Over a slow terminal link that is one round
+// trip per redraw instead of thousands of small writes.
+// In differential mode the frame gets a fixed layout and stays on screen: the
+// lines below it scroll on their own, and later frames only repaint the
+// squares and history lines that changed, a few hundred bytes per move
+class Renderer
+{
+public:
+	// Characters per square horizontally, the square is CELL / 2 lines high
+	static const int CELL = 6;
+
+	// Fixed layout of the differential mode, in lines
+	static const int LOGO_LINES = 10;
+	static const int SITUATION_LINES = 13; // Last moves 7, captures 4, current turn 2
+	static const int BOARD_TOP = LOGO_LINES + SITUATION_LINES + 2;
+	static const int FRAME_LINES = BOARD_TOP + 8 * (CELL / 2);
+
+	// Lines the terminal needs below the frame for the menu and the prompts
+	static const int MIN_ROWS_BELOW = 8;
+
+	Renderer();
+	~Renderer();
+
+	void setDifferential(bool enabled);
+
+	// The logo alone, the screen before a game is started
+	void drawLogo(bool clear);
+
+	// Logo, game situation and board. In differential mode only what changed since the last frame
+	void drawGame(Game& game, bool clear);
+
+private:
+	std::string frame;
+
+	// Lines of the game situation, reused between frames
+	std::vector<std::string> situation;
+	size_t situationCount;
+
+	bool differential;
+	bool drawn;          // A differential frame is on screen and shownBoard/shownSituation match it
+	char shownBoard[8][8];
+	std::vector<std::string> shownSituation;
+
+	void appendClear(void);
+	void appendLogo(void);
+	void appendSituation(Game& game);
+	void buildSituation(Game& game, bool padded);
+	std::string& nextSituationLine(void);
+	void appendBoard(Game& game);
+	void appendLine(Game& game, int line, char color1, char color2);
+
+	// First frame of the differential mode, the whole screen
+	void appendFixedFrame(Game& game);
+
+	// Repaints the squares and situation lines that differ from what is on screen
+	void appendChanges(Game& game);
+
+	// Both 1-based, like the ANSI sequences
+	void appendMoveTo(int row, int column);
+
+	// Gives the whole terminal back to normal scrolling
+	void appendReleaseFrame(void);
+
+	// Lines of the terminal window, 0 when it is not known (e.g. output to a pipe)
+	static int terminalRows(void);
+
+	// Sends the frame after anything still waiting in cout
+	void flush(void);
+};
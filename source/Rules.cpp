@@ -0,0 +1,561 @@
+#include "Rules.h"
+#include "Counters.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
+
+Rules::Rules(Game& game, EventSink sink)
+	: game(game), sink(sink)
+{
+}
+
+Rules::Reason Rules::check(Move& move)
+{
+	CHESS_TRACE_SPAN("validate move");
+
+	Reason reason = checkMove(move);
+	if (VALID == reason)
+	{
+		CHESS_COUNT(LEGAL_MOVES);
+	}
+	else
+	{
+		CHESS_COUNT(ILLEGAL_MOVES);
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkMove(Move& move)
+{
+	Reason reason = INVALID_PIECE;
+	char piece = game.getPieceAtPosition(move.getPresent().row, move.getPresent().column);
+
+	// 1. Is the piece allowed to move in that direction?
+	switch (toupper(piece))
+	{
+	case Chess::PIECE_TYPE_PAWN:
+		reason = checkPawnMovement(&move);
+		break;
+
+	case Chess::PIECE_TYPE_ROOK:
+		reason = checkRookMovement(&move);
+		break;
+
+	case Chess::PIECE_TYPE_KNIGHT:
+		reason = checkKnightMovement(&move);
+		break;
+
+	case Chess::PIECE_TYPE_BISHOP:
+		reason = checkBishopMovement(&move);
+		break;
+
+	case Chess::PIECE_TYPE_QUEEN:
+		reason = checkQueenMovement(&move);
+		break;
+
+	case Chess::PIECE_TYPE_KING:
+		reason = checkKingMovement(&move);
+		break;
+	}
+
+	// If it is a move in an invalid direction, do not even bother to check the rest
+	if (VALID != reason)
+	{
+		return reason;
+	}
+
+	// 2. Is there another piece of the same color on the destination square?
+	if (game.isSquareOccupied(move.getFuture().row, move.getFuture().column) &&
+		Chess::getPieceColor(piece) == Chess::getPieceColor(game.getPieceAtPosition(move.getFuture().row, move.getFuture().column)))
+	{
+		return SQUARE_TAKEN;
+	}
+
+	// 3. Would the king be in check after the move?
+	if (game.wouldKingBeInCheck(piece, &move))
+	{
+		return KING_IN_CHECK;
+	}
+	return VALID;
+}
+
+bool Rules::play(Game& game, const std::string& from, const std::string& to, const std::string& promotion, std::string& error)
+{
+	// Squares like "e2", the same ones the interactive prompts take
+	Chess::Position squares[2];
+	const string* texts[2] = { &from, &to };
+	for (int i = 0; i < 2; i++)
+	{
+		const string& text = *texts[i];
+		if (2 != text.length() || toupper(text[0]) < 'A' || toupper(text[0]) > 'H' || text[1] < '1' || text[1] > '8')
+		{
+			error = "Invalid square \"" + text + "\"";
+			return false;
+		}
+		squares[i].column = toupper(text[0]) - 'A';
+		squares[i].row = text[1] - '1';
+	}
+
+	if (squares[0].row == squares[1].row && squares[0].column == squares[1].column)
+	{
+		error = "Same square twice";
+		return false;
+	}
+
+	char piece = game.getPieceAtPosition(squares[0].row, squares[0].column);
+	if (EMPTY_SQUARE == piece || Chess::getPieceColor(piece) != game.getCurrentTurn())
+	{
+		error = "No piece of the side to move on " + from;
+		return false;
+	}
+
+	Move currentMove;
+	currentMove.setPresent(squares[0]);
+	currentMove.setFuture(squares[1]);
+
+	Rules::Reason reason = Rules(game).check(currentMove);
+	if (Rules::VALID != reason)
+	{
+		error = Rules::describe(reason);
+		return false;
+	}
+
+	if (currentMove.getPromotion()->applied)
+	{
+		char promoted = promotion.empty() ? Chess::PIECE_TYPE_QUEEN : char(toupper(promotion[0]));
+		if (promoted != Chess::PIECE_TYPE_QUEEN
+			&& promoted != Chess::PIECE_TYPE_ROOK
+			&& promoted != Chess::PIECE_TYPE_KNIGHT
+			&& promoted != Chess::PIECE_TYPE_BISHOP)
+		{
+			error = "Invalid promotion \"" + promotion + "\"";
+			return false;
+		}
+
+		Chess::Promotion chosen;
+		chosen.applied = true;
+		chosen.before = piece;
+		chosen.after = Chess::WHITE_PLAYER == game.getCurrentTurn() ? promoted : char(tolower(promoted));
+		currentMove.setPromotion(&chosen);
+	}
+
+	game.movePiece(&currentMove);
+
+	// Marks the game as finished, the same way checkIfKingInCheck() does
+	if (game.isPlayerKingInCheck())
+	{
+		game.isCheckMate();
+	}
+	return true;
+}
+
+bool Rules::playRecord(Game& game, const std::string& record, std::string& error)
+{
+	// "E2-E4" or "E7-E8=Q", the form of the saved games
+	string promotion = record.size() > 6 && '=' == record[5] ? record.substr(6, 1) : string();
+	if (record.size() < 5 || !play(game, record.substr(0, 2), record.substr(3, 2), promotion, error))
+	{
+		error = "invalid move " + record + (error.empty() ? "" : ": " + error);
+		return false;
+	}
+	return true;
+}
+
+bool Rules::replay(Game& game, std::istream& is, std::string& error)
+{
+	std::deque<Game::Round> rounds;
+	Game::loadRounds(is, rounds);
+	return replay(game, rounds, error);
+}
+
+bool Rules::replay(Game& game, const std::deque<Game::Round>& rounds, std::string& error)
+{
+	CHESS_TRACE_SPAN("replay", "rounds", int64_t(rounds.size()));
+
+	for (size_t i = 0; i < rounds.size(); i++)
+	{
+		const string* records[2] = { &rounds[i].whiteMove, &rounds[i].blackMove };
+		for (int j = 0; j < 2 && !records[j]->empty(); j++)
+		{
+			if (!playRecord(game, *records[j], error))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+std::string Rules::describe(Reason reason)
+{
+	CHESS_ALLOC_SCOPE(MESSAGE);
+
+	switch (reason)
+	{
+	case VALID:                           return "Valid move";
+	case INVALID_PIECE:                   return "There is no piece to move on that square";
+	case ILLEGAL_DIRECTION:               return "Piece is not allowed to move to that square";
+	case PATH_BLOCKED:                    return "The path to that square is not clear";
+	case SQUARE_TAKEN:                    return "Position is already taken by a piece of the same color";
+	case KING_IN_CHECK:                   return "Move would put player's king in check";
+	case CASTLING_IN_CHECK:               return "Castling is not allowed while the king is in check";
+	case CASTLING_THROUGH_CHECK:          return "Castling is not allowed through an attacked square";
+	case KING_SIDE_CASTLING_NOT_ALLOWED:  return "Castling to the king side is not allowed";
+	case QUEEN_SIDE_CASTLING_NOT_ALLOWED: return "Castling to the queen side is not allowed";
+	}
+	return "";
+}
+
+std::string Rules::describe(Event event)
+{
+	CHESS_ALLOC_SCOPE(MESSAGE);
+
+	switch (event)
+	{
+	case EN_PASSANT:   return "En passant move!";
+	case PAWN_CAPTURE: return "Pawn captured a piece!";
+	case PROMOTION:    return "Pawn must be promoted!";
+	}
+	return "";
+}
+
+void Rules::report(Event event) const
+{
+	if (sink)
+	{
+		sink(event);
+	}
+}
+
+Rules::Reason Rules::checkPawnMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	char piece = game.getPieceAtPosition(currentMove->getPresent().row, currentMove->getPresent().column);
+	// Wants to move forward
+	if (currentMove->getFuture().column == currentMove->getPresent().column)
+	{
+		// Simple move forward
+		if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 1) ||
+			(Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 1))
+		{
+			if (EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column))
+			{
+				reason = VALID;
+			}
+		}
+
+		// Double move forward
+		else if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 2) ||
+			(Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 2))
+		{
+			// This is only allowed if the pawn is in its original place
+			if (Chess::isWhitePiece(piece))
+			{
+				if (EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row - 1, currentMove->getFuture().column) &&
+					EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column) &&
+					1 == currentMove->getPresent().row)
+				{
+					reason = VALID;
+				}
+			}
+			else // if ( isBlackPiece(piece) )
+			{
+				if (EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row + 1, currentMove->getFuture().column) &&
+					EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column) &&
+					6 == currentMove->getPresent().row)
+				{
+					reason = VALID;
+				}
+			}
+		}
+		else
+		{
+			// This is invalid
+			return ILLEGAL_DIRECTION;
+		}
+	}
+
+	// The "en passant" move (a diagonal move to an empty square, otherwise it is a normal capture)
+	else if (((Chess::isWhitePiece(piece) && 4 == currentMove->getPresent().row && 5 == currentMove->getFuture().row && 1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)) ||
+		(Chess::isBlackPiece(piece) && 3 == currentMove->getPresent().row && 2 == currentMove->getFuture().row && 1 == abs(currentMove->getFuture().column - currentMove->getPresent().column))) &&
+		EMPTY_SQUARE == game.getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column))
+	{
+		// It is only valid if last move of the opponent was a double move forward by a pawn on a adjacent column
+		if (0 == game.getPlyCount())
+		{
+			return ILLEGAL_DIRECTION;
+		}
+		const CompactMove& last_move = game.getPly(game.getPlyCount() - 1);
+		Chess::Position LastMoveFrom = { Board::rowOf(last_move.from), Board::columnOf(last_move.from) };
+		Chess::Position LastMoveTo = { Board::rowOf(last_move.to), Board::columnOf(last_move.to) };
+
+		// First of all, was it a pawn?
+		char chLstMvPiece = game.getPieceAtPosition(LastMoveTo.row, LastMoveTo.column);
+
+		if (toupper(chLstMvPiece) != 'P')
+		{
+			return ILLEGAL_DIRECTION;
+		}
+
+		// Did the pawn have a double move forward and was it an adjacent column?
+		if (2 == abs(LastMoveTo.row - LastMoveFrom.row) && 1 == abs(LastMoveFrom.column - currentMove->getPresent().column))
+		{
+			report(EN_PASSANT);
+			reason = VALID;
+
+			currentMove->getEnPassant()->applied = true;
+			currentMove->getEnPassant()->PawnCaptured.row = LastMoveTo.row;
+			currentMove->getEnPassant()->PawnCaptured.column = LastMoveTo.column;
+		}
+	}
+
+	// Wants to capture a piece
+	else if (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column))
+	{
+		if ((Chess::isWhitePiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row + 1) || (Chess::isBlackPiece(piece) && currentMove->getFuture().row == currentMove->getPresent().row - 1))
+		{
+			// Only allowed if there is something to be captured in the square
+			if (EMPTY_SQUARE != game.getPieceAtPosition(currentMove->getFuture().row, currentMove->getFuture().column))
+			{
+				reason = VALID;
+				report(PAWN_CAPTURE);
+			}
+		}
+	}
+	else
+	{
+		// This is invalid
+		return ILLEGAL_DIRECTION;
+	}
+
+	// If a pawn reaches its eight rank, it must be promoted to another piece
+	if ((Chess::isWhitePiece(piece) && 7 == currentMove->getFuture().row) ||
+		(Chess::isBlackPiece(piece) && 0 == currentMove->getFuture().row))
+	{
+		report(PROMOTION);
+		currentMove->getPromotion()->applied = true;
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkRookMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	// Horizontal move
+	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (currentMove->getFuture().column != currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+	// Vertical move
+	else if ((currentMove->getFuture().row != currentMove->getPresent().row) && (currentMove->getFuture().column == currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::VERTICAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkKnightMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	if ((2 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
+	{
+		reason = VALID;
+	}
+
+	else if ((1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (2 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
+	{
+		reason = VALID;
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkBishopMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	// Diagonal move
+	if (abs(currentMove->getFuture().row - currentMove->getPresent().row) == abs(currentMove->getFuture().column - currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::DIAGONAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkQueenMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	// Horizontal move
+	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (currentMove->getFuture().column != currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+	// Vertical move
+	else if ((currentMove->getFuture().row != currentMove->getPresent().row) && (currentMove->getFuture().column == currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::VERTICAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+
+	// Diagonal move
+	else if (abs(currentMove->getFuture().row - currentMove->getPresent().row) == abs(currentMove->getFuture().column - currentMove->getPresent().column))
+	{
+		// Check if there are no pieces on the way
+		if (game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::DIAGONAL))
+		{
+			reason = VALID;
+		}
+		else
+		{
+			reason = PATH_BLOCKED;
+		}
+	}
+	return reason;
+}
+
+Rules::Reason Rules::checkKingMovement(Move* currentMove)
+{
+	Reason reason = ILLEGAL_DIRECTION;
+	char piece = game.getPieceAtPosition(currentMove->getPresent().row, currentMove->getPresent().column);
+	// Horizontal move by 1
+	if ((currentMove->getFuture().row == currentMove->getPresent().row) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
+	{
+		reason = VALID;
+	}
+
+	// Vertical move by 1
+	else if ((currentMove->getFuture().column == currentMove->getPresent().column) && (1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)))
+	{
+		reason = VALID;
+	}
+
+	// Diagonal move by 1
+	else if ((1 == abs(currentMove->getFuture().row - currentMove->getPresent().row)) && (1 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
+	{
+		reason = VALID;
+	}
+
+	// Castling
+	else if ((currentMove->getFuture().row == currentMove->getPresent().row) && (2 == abs(currentMove->getFuture().column - currentMove->getPresent().column)))
+	{
+		// Castling is only allowed in these circunstances:
+
+		// 1. King is not in check
+		if (game.isPlayerKingInCheck())
+		{
+			return CASTLING_IN_CHECK;
+		}
+
+		// 2. No pieces in between the king and the rook
+		if (!game.isPathFree(currentMove->getPresent(), currentMove->getFuture(), Chess::HORIZONTAL))
+		{
+			return PATH_BLOCKED;
+		}
+
+		// 3. King and rook must not have moved yet;
+		// 4. King must not pass through a square that is attacked by an enemy piece
+		if (currentMove->getFuture().column > currentMove->getPresent().column)
+		{
+			// if currentMove->getFuture().column is greather, it means king side
+			if (!game.isCastlingAllowed(Chess::Side::KING_SIDE, Chess::getPieceColor(piece)))
+			{
+				return KING_SIDE_CASTLING_NOT_ALLOWED;
+			}
+			else
+			{
+				// Check if the square that the king skips is not under attack
+				Chess::Position currentPosition = { currentMove->getPresent().row, currentMove->getPresent().column + 1 };
+				Chess::UnderAttack square_skipped = game.underAttack(currentPosition, game.getCurrentTurn());
+				if (!square_skipped.underAttack)
+				{
+					// Fill the currentMove->getCastling() structure
+					currentMove->getCastling()->applied = true;
+
+					// currentMove->getPresent() position of the rook
+					currentMove->getCastling()->rookBefore.row = currentMove->getPresent().row;
+					currentMove->getCastling()->rookBefore.column = currentMove->getPresent().column + 3;
+
+					// currentMove->getFuture() position of the rook
+					currentMove->getCastling()->rookAfter.row = currentMove->getFuture().row;
+					currentMove->getCastling()->rookAfter.column = currentMove->getPresent().column + 1; // currentMove->getFuture().column -1
+
+					reason = VALID;
+				}
+				else
+				{
+					reason = CASTLING_THROUGH_CHECK;
+				}
+			}
+		}
+		else //if (currentMove->getFuture().column < currentMove->getPresent().column)
+		{
+			// if currentMove->getPresent().column is greather, it means queen side
+			if (!game.isCastlingAllowed(Chess::Side::QUEEN_SIDE, Chess::getPieceColor(piece)))
+			{
+				return QUEEN_SIDE_CASTLING_NOT_ALLOWED;
+			}
+			else
+			{
+				// Check if the square that the king skips is not attacked
+				Chess::Position currentPosition = { currentMove->getPresent().row, currentMove->getPresent().column - 1 };
+				Chess::UnderAttack square_skipped = game.underAttack(currentPosition, game.getCurrentTurn());
+				if (!square_skipped.underAttack)
+				{
+					// Fill the currentMove->getCastling() structure
+					currentMove->getCastling()->applied = true;
+
+					// currentMove->getPresent() position of the rook
+					currentMove->getCastling()->rookBefore.row = currentMove->getPresent().row;
+					currentMove->getCastling()->rookBefore.column = currentMove->getPresent().column - 4;
+
+					// currentMove->getFuture() position of the rook
+					currentMove->getCastling()->rookAfter.row = currentMove->getFuture().row;
+					currentMove->getCastling()->rookAfter.column = currentMove->getPresent().column - 1; // currentMove->getFuture().column +1
+
+					reason = VALID;
+				}
+				else
+				{
+					reason = CASTLING_THROUGH_CHECK;
+				}
+			}
+		}
+	}
+	return reason;
+}
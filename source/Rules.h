@@ -0,0 +1,75 @@
+#pragma once
+#include "includes.h"
+#include <functional>
+#include "chess.h"
+#include "game.h"
+#include "Move.h"
+
+// The move rules of the console game, without any output. A move is checked
+// against a Game and the answer is a reason code, so the same checks can run
+// in bulk (loading a game, generating candidates) at full speed. Things worth
+// telling the player along the way go to an optional event sink, the console
+// renders both
+class Rules
+{
+public:
+	enum Reason
+	{
+		VALID,
+		INVALID_PIECE,                  // Nothing that can move on the starting square
+		ILLEGAL_DIRECTION,              // The piece does not move like that
+		PATH_BLOCKED,                   // Another piece stands in the way
+		SQUARE_TAKEN,                   // A piece of the same color is on the destination square
+		KING_IN_CHECK,                  // The move would leave the own king in check
+		CASTLING_IN_CHECK,
+		CASTLING_THROUGH_CHECK,         // The square the king skips is attacked
+		KING_SIDE_CASTLING_NOT_ALLOWED,
+		QUEEN_SIDE_CASTLING_NOT_ALLOWED
+	};
+
+	enum Event
+	{
+		EN_PASSANT,
+		PAWN_CAPTURE,
+		PROMOTION                       // The pawn reaches the last rank, a piece has to be chosen
+	};
+
+	typedef std::function<void(Event)> EventSink;
+
+	explicit Rules(Game& game, EventSink sink = EventSink());
+
+	// Checks the move and fills its castling, en passant and promotion details
+	Reason check(Move& move);
+
+	// Plays a move given as squares ("e2", "e4") and a promotion piece ("Q", a
+	// queen when empty). False with the error filled when it is not legal
+	static bool play(Game& game, const std::string& from, const std::string& to, const std::string& promotion, std::string& error);
+
+	// The same for a move of a saved game, "E2-E4" or "E7-E8=Q"
+	static bool playRecord(Game& game, const std::string& record, std::string& error);
+
+	// Plays all the moves of a saved game, stopping at the first one that is not legal
+	static bool replay(Game& game, std::istream& is, std::string& error);
+
+	// The same for moves already read with Game::loadRounds
+	static bool replay(Game& game, const std::deque<Game::Round>& rounds, std::string& error);
+
+	static std::string describe(Reason reason);
+
+	static std::string describe(Event event);
+
+private:
+	Game& game;
+	EventSink sink;
+
+	void report(Event event) const;
+
+	Reason checkMove(Move& move);
+
+	Reason checkPawnMovement(Move* currentMove);
+	Reason checkRookMovement(Move* currentMove);
+	Reason checkKnightMovement(Move* currentMove);
+	Reason checkBishopMovement(Move* currentMove);
+	Reason checkQueenMovement(Move* currentMove);
+	Reason checkKingMovement(Move* currentMove);
+};
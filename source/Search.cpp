@@ -0,0 +1,652 @@
+#include "Search.h"
+#include "Tablebase.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace
+{
+	// Values used to order captures (most valuable victim, least valuable attacker)
+	const int ORDER_VALUE[Evaluation::PIECE_KINDS + 1] = { 100, 320, 330, 500, 900, 2000, 0 };
+
+	const int HASH_MOVE_SCORE = 1000000;
+	const int CAPTURE_SCORE = 100000;
+	const int PROMOTION_SCORE = 90000;
+	const int KILLER_SCORE = 80000;
+
+	const int ASPIRATION_WINDOW = 25;
+}
+
+Search::Search(TranspositionTable& table)
+	: table(table)
+{
+	stopRequested.store(false);
+	aborted = false;
+	ponderHitRequested.store(false);
+	pondering = false;
+	rootSide = Chess::WHITE_PLAYER;
+	nodes = 0;
+	publishedNodes.store(0);
+	isHelper = false;
+	multiPv = 1;
+	lineMove = CompactMove::null();
+	tablebases = nullptr;
+	probeEverywhere = false;
+	rootKeyIndex = 0;
+	memset(pvLength, 0, sizeof(pvLength));
+	memset(killers, 0, sizeof(killers));
+	memset(history, 0, sizeof(history));
+}
+
+Search::Result Search::think(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& gameHistory)
+{
+	CHESS_TRACE_SPAN("search");
+
+	Result result;
+	result.bestMove = CompactMove::null();
+	result.ponderMove = CompactMove::null();
+	result.score = 0;
+	result.depth = 0;
+	result.nodes = 0;
+	result.elapsed = 0;
+
+	nodes = 0;
+	publishedNodes.store(0, std::memory_order_relaxed);
+	aborted = false;
+	if (!isHelper)
+	{
+		table.newSearch();
+	}
+
+	// While pondering the clock is not ours yet, the limits apply from the ponder hit
+	pondering = limits.ponder;
+	ponderLimits = limits;
+	ponderLimits.ponder = false;
+	rootSide = board.sideToMove;
+	if (pondering)
+	{
+		SearchLimits ponderingLimits;
+		ponderingLimits.infinite = true;
+		timeManager.start(ponderingLimits, board.sideToMove);
+	}
+	else
+	{
+		timeManager.start(limits, board.sideToMove);
+	}
+
+	keys = gameHistory;
+	rootKeyIndex = keys.size();
+	keys.push_back(board.hash);
+
+	memset(killers, 0, sizeof(killers));
+	memset(history, 0, sizeof(history));
+
+	int rootValue;
+	probeEverywhere = nullptr != tablebases && tablebases->probe(board, rootValue);
+
+	Board::MoveList rootMoves;
+	board.generateLegalMoves(rootMoves);
+
+	// Only the moves the caller picked, when they are legal here
+	rootSearchMoves.clear();
+	Board::MoveList pickedMoves;
+	pickedMoves.count = 0;
+	for (int i = 0; i < rootMoves.count; i++)
+	{
+		if (limits.searchMoves.end() != std::find(limits.searchMoves.begin(), limits.searchMoves.end(), rootMoves.moves[i]))
+		{
+			pickedMoves.moves[pickedMoves.count++] = rootMoves.moves[i];
+			rootSearchMoves.push_back(rootMoves.moves[i]);
+		}
+	}
+	if (pickedMoves.count > 0)
+	{
+		rootMoves = pickedMoves;
+	}
+
+	if (0 == rootMoves.count)
+	{
+		// Checkmate or stalemate, nothing to search
+		result.score = board.isInCheck() ? -MATE_SCORE : 0;
+		return result;
+	}
+
+	// Something to play even if we are stopped before the first iteration ends
+	result.bestMove = rootMoves.moves[0];
+
+	int maxDepth = limits.depth > 0 ? std::min(limits.depth, int(MAX_PLY)) : int(MAX_PLY);
+	int lineCount = std::min(multiPv, rootMoves.count);
+	std::vector<int> lineScores(lineCount, 0);
+	std::vector<CompactMove> lineMoves(lineCount, CompactMove::null());
+	int score = 0;
+
+	for (int depth = 1; depth <= maxDepth; depth++)
+	{
+		CHESS_TRACE_SPAN("search iteration", "depth", depth);
+
+		std::vector<Line> lines;
+		excludedRootMoves.clear();
+
+		for (int lineIndex = 0; lineIndex < lineCount && !aborted; lineIndex++)
+		{
+			int alpha = -INFINITE_SCORE;
+			int beta = INFINITE_SCORE;
+			int window = ASPIRATION_WINDOW;
+			lineMove = lineIndex > 0 ? lineMoves[lineIndex] : CompactMove::null();
+
+			// From depth 5 on, search a narrow window around the last score first
+			if (depth >= 5 && !isMateScore(lineScores[lineIndex]))
+			{
+				alpha = std::max(lineScores[lineIndex] - window, -INFINITE_SCORE);
+				beta = std::min(lineScores[lineIndex] + window, int(INFINITE_SCORE));
+			}
+
+			while (true)
+			{
+				score = alphaBeta(board, depth, alpha, beta, 0, false);
+				if (aborted)
+				{
+					break;
+				}
+
+				if (score <= alpha)
+				{
+					alpha = std::max(score - window, -INFINITE_SCORE);
+				}
+				else if (score >= beta)
+				{
+					beta = std::min(score + window, int(INFINITE_SCORE));
+				}
+				else
+				{
+					break;
+				}
+				window *= 2;
+			}
+
+			if (!aborted)
+			{
+				Line line;
+				line.score = score;
+				line.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+				lines.push_back(line);
+				excludedRootMoves.push_back(pvTable[0][0]);
+			}
+		}
+		excludedRootMoves.clear();
+
+		if (aborted)
+		{
+			// The unfinished iteration is thrown away
+			break;
+		}
+
+		// A later pass can come out higher than an earlier one when the window had to be widened
+		std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.score > b.score; });
+		for (int i = 0; i < lineCount; i++)
+		{
+			lineScores[i] = lines[i].score;
+			lineMoves[i] = lines[i].pv[0];
+		}
+		score = lines[0].score;
+
+		result.bestMove = lines[0].pv[0];
+		result.score = score;
+		result.depth = depth;
+		result.pv = lines[0].pv;
+		result.ponderMove = result.pv.size() > 1 ? result.pv[1] : CompactMove::null();
+		result.lines = lines;
+		result.nodes = nodes;
+		result.elapsed = timeManager.getElapsed();
+
+		if (onIteration && !isHelper)
+		{
+			onIteration(result);
+		}
+
+		if (timeManager.shouldStopAfterIteration(depth, result.bestMove, score))
+		{
+			break;
+		}
+
+		// Only one move to play: no need to think about it on the clock
+		if (1 == rootMoves.count && timeManager.isClockControlled())
+		{
+			break;
+		}
+
+		// A mate that fits in the searched depth will not get any better
+		if (!limits.infinite && !pondering && isMateScore(score) && MATE_SCORE - abs(score) <= depth)
+		{
+			break;
+		}
+	}
+
+	result.nodes = nodes;
+	result.elapsed = timeManager.getElapsed();
+	publishedNodes.store(nodes, std::memory_order_relaxed);
+	keys.resize(rootKeyIndex);
+	return result;
+}
+
+bool Search::checkLimits(void)
+{
+	nodes++;
+
+	if (0 == (nodes & (TimeManager::POLL_INTERVAL - 1)))
+	{
+		publishedNodes.store(nodes, std::memory_order_relaxed);
+		if (stopRequested.load(std::memory_order_relaxed))
+		{
+			aborted = true;
+		}
+
+		// The clock starts with the ponder hit
+		if (pondering && ponderHitRequested.load(std::memory_order_relaxed))
+		{
+			pondering = false;
+			timeManager.start(ponderLimits, rootSide);
+		}
+	}
+
+	if (timeManager.isNodeLimitReached(nodes) || timeManager.isTimeUp(nodes))
+	{
+		aborted = true;
+	}
+
+	return aborted;
+}
+
+bool Search::isDraw(const Board& board) const
+{
+	if (board.halfmoveClock >= 100)
+	{
+		return true;
+	}
+
+	// The current position is the last key. Only positions since the last
+	// capture or pawn move can repeat, and only with the same side to move
+	int current = int(keys.size()) - 1;
+	int oldest = std::max(0, current - board.halfmoveClock);
+
+	for (int i = current - 2; i >= oldest; i -= 2)
+	{
+		if (keys[i] == board.hash)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Search::updatePv(int ply, const CompactMove& move)
+{
+	pvTable[ply][ply] = move;
+	for (int i = ply + 1; i < pvLength[ply + 1]; i++)
+	{
+		pvTable[ply][i] = pvTable[ply + 1][i];
+	}
+	pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+}
+
+int Search::scoreToTable(int score, int ply)
+{
+	// Mate scores are stored relative to the position, not to the root
+	if (score > MATE_BOUND)
+	{
+		return score + ply;
+	}
+	if (score < -MATE_BOUND)
+	{
+		return score - ply;
+	}
+	return score;
+}
+
+int Search::scoreFromTable(int score, int ply)
+{
+	if (score > MATE_BOUND)
+	{
+		return score - ply;
+	}
+	if (score < -MATE_BOUND)
+	{
+		return score + ply;
+	}
+	return score;
+}
+
+int Search::tablebaseScore(int value, int ply)
+{
+	if (value > 0)
+	{
+		return MATE_SCORE - ply - value;
+	}
+	if (value < 0)
+	{
+		return -MATE_SCORE + ply - value - 1;
+	}
+	return 0;
+}
+
+void Search::scoreMoves(const Board& board, const Board::MoveList& list, const CompactMove& hashMove, int ply, int* scores) const
+{
+	for (int i = 0; i < list.count; i++)
+	{
+		const CompactMove& move = list.moves[i];
+
+		if (move == hashMove)
+		{
+			scores[i] = HASH_MOVE_SCORE;
+		}
+		else if (move.isCapture())
+		{
+			int victim = (move.flags & CompactMove::FLAG_EN_PASSANT) ? int(Evaluation::PAWN) : Evaluation::pieceKind(board.squares[move.to]);
+			int attacker = Evaluation::pieceKind(board.squares[move.from]);
+			scores[i] = CAPTURE_SCORE + ORDER_VALUE[victim] * 10 - ORDER_VALUE[attacker] / 10;
+		}
+		else if (move.flags & CompactMove::FLAG_PROMOTION)
+		{
+			scores[i] = PROMOTION_SCORE + ORDER_VALUE[Evaluation::pieceKind(move.promotion)];
+		}
+		else if (move == killers[ply][0])
+		{
+			scores[i] = KILLER_SCORE;
+		}
+		else if (move == killers[ply][1])
+		{
+			scores[i] = KILLER_SCORE - 1;
+		}
+		else
+		{
+			scores[i] = history[move.from][move.to];
+		}
+	}
+}
+
+CompactMove Search::pickMove(Board::MoveList& list, int* scores, int index)
+{
+	// Selection sort, one step at a time: after a cutoff the rest is never sorted
+	int best = index;
+	for (int i = index + 1; i < list.count; i++)
+	{
+		if (scores[i] > scores[best])
+		{
+			best = i;
+		}
+	}
+
+	std::swap(list.moves[index], list.moves[best]);
+	std::swap(scores[index], scores[best]);
+	return list.moves[index];
+}
+
+int Search::alphaBeta(const Board& board, int depth, int alpha, int beta, int ply, bool nullAllowed)
+{
+	pvLength[ply] = ply;
+
+	if (depth <= 0)
+	{
+		return quiesce(board, alpha, beta, ply);
+	}
+
+	if (checkLimits())
+	{
+		return 0;
+	}
+
+	if (ply > 0)
+	{
+		if (isDraw(board))
+		{
+			return 0;
+		}
+
+		// Mate distance pruning: a shorter mate was already found
+		alpha = std::max(alpha, -MATE_SCORE + ply);
+		beta = std::min(beta, MATE_SCORE - ply - 1);
+		if (alpha >= beta)
+		{
+			return alpha;
+		}
+
+		// Material only changes with a capture or a pawn move, so above the
+		// tables' size the other positions can't be in them
+		int value;
+		if (nullptr != tablebases && (probeEverywhere || 0 == board.halfmoveClock) && tablebases->probe(board, value))
+		{
+			return tablebaseScore(value, ply);
+		}
+	}
+
+	if (ply >= MAX_PLY)
+	{
+		return evaluation.evaluate(board);
+	}
+
+	bool pvNode = beta - alpha > 1;
+	int alphaOriginal = alpha;
+
+	// Transposition table
+	CompactMove hashMove = CompactMove::null();
+	TranspositionTable::Entry entry;
+	if (table.probe(board.hash, entry))
+	{
+		hashMove = entry.move;
+
+		if (!pvNode && ply > 0 && entry.depth >= depth)
+		{
+			int score = scoreFromTable(entry.score, ply);
+			if (TranspositionTable::BOUND_EXACT == entry.bound ||
+				(TranspositionTable::BOUND_LOWER == entry.bound && score >= beta) ||
+				(TranspositionTable::BOUND_UPPER == entry.bound && score <= alpha))
+			{
+				return score;
+			}
+		}
+	}
+
+	if (0 == ply && !lineMove.isNull())
+	{
+		hashMove = lineMove;
+	}
+
+	bool inCheck = board.isInCheck();
+	if (inCheck)
+	{
+		// Check extension
+		depth++;
+	}
+
+	// Null move pruning: if passing still beats beta, a real move will do too
+	if (nullAllowed && !pvNode && !inCheck && depth >= 3 && beta < MATE_BOUND &&
+		board.hasNonPawnMaterial(board.sideToMove) && evaluation.evaluate(board) >= beta)
+	{
+		Board child = board;
+		child.makeNullMove();
+		keys.push_back(child.hash);
+		int score = -alphaBeta(child, depth - 3, -beta, -beta + 1, ply + 1, false);
+		keys.pop_back();
+
+		if (aborted)
+		{
+			return 0;
+		}
+		if (score >= beta)
+		{
+			return isMateScore(score) ? beta : score;
+		}
+	}
+
+	Board::MoveList list;
+	board.generateMoves(list);
+
+	int scores[Board::MAX_MOVES];
+	scoreMoves(board, list, hashMove, ply, scores);
+
+	int legalMoves = 0;
+	int bestScore = -INFINITE_SCORE;
+	CompactMove bestMove = CompactMove::null();
+
+	for (int i = 0; i < list.count; i++)
+	{
+		CompactMove move = pickMove(list, scores, i);
+
+		// Multi-PV: the lines already reported in this iteration
+		if (0 == ply && excludedRootMoves.end() != std::find(excludedRootMoves.begin(), excludedRootMoves.end(), move))
+		{
+			continue;
+		}
+
+		// "go searchmoves": the other root moves are not considered
+		if (0 == ply && !rootSearchMoves.empty() && rootSearchMoves.end() == std::find(rootSearchMoves.begin(), rootSearchMoves.end(), move))
+		{
+			continue;
+		}
+
+		Board child = board;
+		if (!child.makeMove(move))
+		{
+			continue;
+		}
+		legalMoves++;
+
+		keys.push_back(child.hash);
+
+		int score;
+		if (1 == legalMoves)
+		{
+			score = -alphaBeta(child, depth - 1, -beta, -alpha, ply + 1, true);
+		}
+		else
+		{
+			// Late move reduction for quiet moves that are ordered late
+			int reduction = 0;
+			if (depth >= 3 && legalMoves > 3 && !inCheck && move.isQuiet() &&
+				move != killers[ply][0] && move != killers[ply][1] && !child.isInCheck())
+			{
+				reduction = 1;
+			}
+
+			// Principal variation search: prove the move is worse with a null window
+			score = -alphaBeta(child, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true);
+
+			if (score > alpha && reduction > 0)
+			{
+				score = -alphaBeta(child, depth - 1, -alpha - 1, -alpha, ply + 1, true);
+			}
+
+			if (score > alpha && score < beta)
+			{
+				score = -alphaBeta(child, depth - 1, -beta, -alpha, ply + 1, true);
+			}
+		}
+
+		keys.pop_back();
+
+		if (aborted)
+		{
+			return 0;
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = move;
+
+			if (score > alpha)
+			{
+				alpha = score;
+				updatePv(ply, move);
+
+				if (alpha >= beta)
+				{
+					if (move.isQuiet())
+					{
+						if (move != killers[ply][0])
+						{
+							killers[ply][1] = killers[ply][0];
+							killers[ply][0] = move;
+						}
+						history[move.from][move.to] += depth * depth;
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	if (0 == legalMoves)
+	{
+		// Checkmate or stalemate
+		return inCheck ? -MATE_SCORE + ply : 0;
+	}
+
+	// With root moves left out the result is not the position's
+	if (0 == ply && (!excludedRootMoves.empty() || !rootSearchMoves.empty()))
+	{
+		return bestScore;
+	}
+
+	int bound = bestScore >= beta ? TranspositionTable::BOUND_LOWER :
+		(bestScore > alphaOriginal ? TranspositionTable::BOUND_EXACT : TranspositionTable::BOUND_UPPER);
+	table.store(board.hash, bestMove, scoreToTable(bestScore, ply), depth, bound);
+
+	return bestScore;
+}
+
+int Search::quiesce(const Board& board, int alpha, int beta, int ply)
+{
+	pvLength[ply] = ply;
+
+	if (checkLimits())
+	{
+		return 0;
+	}
+
+	int standPat = evaluation.evaluate(board);
+	if (ply >= MAX_PLY || standPat >= beta)
+	{
+		return standPat;
+	}
+	if (standPat > alpha)
+	{
+		alpha = standPat;
+	}
+
+	Board::MoveList list;
+	board.generateMoves(list, true);
+
+	int scores[Board::MAX_MOVES];
+	scoreMoves(board, list, CompactMove::null(), ply, scores);
+
+	for (int i = 0; i < list.count; i++)
+	{
+		CompactMove move = pickMove(list, scores, i);
+
+		Board child = board;
+		if (!child.makeMove(move))
+		{
+			continue;
+		}
+
+		int score = -quiesce(child, -beta, -alpha, ply + 1);
+		if (aborted)
+		{
+			return 0;
+		}
+
+		if (score > alpha)
+		{
+			alpha = score;
+			updatePv(ply, move);
+
+			if (alpha >= beta)
+			{
+				break;
+			}
+		}
+	}
+
+	return alpha;
+}
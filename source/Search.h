@@ -0,0 +1,148 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+#include "Evaluation.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <functional>
+
+class Tablebases;
+
+// Iterative deepening alpha-beta search
+class Search
+{
+public:
+	static const int MAX_PLY = 64;
+	static const int INFINITE_SCORE = 32001;
+	static const int MATE_SCORE = 32000;
+
+	// Scores above this are "mate in N". Tablebase mates can be further away than the search can see
+	static const int MATE_BOUND = MATE_SCORE - 256;
+
+	static const int MAX_MULTI_PV = 64;
+
+	// One of the best root moves with its score and principal variation
+	struct Line
+	{
+		int score;
+		std::vector<CompactMove> pv;
+	};
+
+	struct Result
+	{
+		CompactMove bestMove;
+		CompactMove ponderMove;
+		int score;
+		int depth;
+		uint64_t nodes;
+		long long elapsed;
+		std::vector<CompactMove> pv;
+		std::vector<Line> lines; // Best first, as many as the multi-PV setting and the legal moves allow
+	};
+
+	typedef std::function<void(const Result&)> IterationCallback;
+
+	explicit Search(TranspositionTable& table);
+
+	// Called after every completed iteration, from the searching thread
+	void setIterationCallback(IterationCallback callback) { onIteration = callback; }
+
+	// Helper threads share the table with the main search thread but leave
+	// the table generation and the reporting to it
+	void setHelper(bool helper) { isHelper = helper; }
+
+	// Number of best root moves reported with their own PV. Every iteration
+	// searches the root once per line, leaving out the moves already reported;
+	// the later passes are cheap because the table already knows the tree
+	void setMultiPv(int count) { multiPv = std::max(1, std::min(count, int(MAX_MULTI_PV))); }
+
+	int getMultiPv(void) const { return multiPv; }
+
+	// Endgame tables probed during the search, nullptr for none. They must outlive the search
+	void setTablebases(const Tablebases* tables) { tablebases = tables; }
+
+	// Searches the position within the limits. gameHistory holds the hash keys of
+	// the positions played before this one (oldest first), to detect repetitions
+	Result think(const Board& board, const SearchLimits& limits, const std::vector<uint64_t>& gameHistory = std::vector<uint64_t>());
+
+	// Can be called from another thread. The search finishes as soon as possible
+	// and any later search returns right away until clearStop() is called
+	void stop(void) { stopRequested.store(true, std::memory_order_relaxed); }
+
+	void clearStop(void)
+	{
+		stopRequested.store(false, std::memory_order_relaxed);
+		ponderHitRequested.store(false, std::memory_order_relaxed);
+	}
+
+	// Can be called from another thread. A search started with limits.ponder
+	// goes on from there with its other limits, its clock starting now
+	void ponderHit(void) { ponderHitRequested.store(true, std::memory_order_relaxed); }
+
+	// Safe to read from another thread, updated every TimeManager::POLL_INTERVAL nodes
+	uint64_t getNodes(void) const { return publishedNodes.load(std::memory_order_relaxed); }
+
+	Evaluation& getEvaluation(void) { return evaluation; }
+
+	TimeManager& getTimeManager(void) { return timeManager; }
+
+	static bool isMateScore(int score) { return score > MATE_BOUND || score < -MATE_BOUND; }
+
+private:
+	TranspositionTable& table;
+	Evaluation evaluation;
+	TimeManager timeManager;
+
+	std::atomic<bool> stopRequested;
+	bool aborted;
+
+	// Pondering: searching as infinite until ponderHit(), then to these limits
+	std::atomic<bool> ponderHitRequested;
+	bool pondering;
+	SearchLimits ponderLimits;
+	int rootSide;
+	uint64_t nodes;
+	std::atomic<uint64_t> publishedNodes;
+
+	IterationCallback onIteration;
+	bool isHelper;
+
+	int multiPv;
+	std::vector<CompactMove> excludedRootMoves;
+	std::vector<CompactMove> rootSearchMoves; // The only root moves searched, empty for all
+	CompactMove lineMove; // Searched first at the root: this line's move in the previous iteration
+
+	const Tablebases* tablebases;
+	bool probeEverywhere; // The root is already in the tables, not only the positions after a capture or pawn move
+
+	// Hash keys of the game so far followed by the current search path
+	std::vector<uint64_t> keys;
+	size_t rootKeyIndex;
+
+	CompactMove pvTable[MAX_PLY + 1][MAX_PLY + 1];
+	int pvLength[MAX_PLY + 1];
+	CompactMove killers[MAX_PLY + 1][2];
+	int history[64][64];
+
+	int alphaBeta(const Board& board, int depth, int alpha, int beta, int ply, bool nullAllowed);
+
+	int quiesce(const Board& board, int alpha, int beta, int ply);
+
+	bool checkLimits(void);
+
+	bool isDraw(const Board& board) const;
+
+	void scoreMoves(const Board& board, const Board::MoveList& list, const CompactMove& hashMove, int ply, int* scores) const;
+
+	static CompactMove pickMove(Board::MoveList& list, int* scores, int index);
+
+	void updatePv(int ply, const CompactMove& move);
+
+	static int scoreToTable(int score, int ply);
+
+	static int scoreFromTable(int score, int ply);
+
+	// Tablebase value (plies to mate, see Tablebase) as a search score
+	static int tablebaseScore(int value, int ply);
+};
@@ -0,0 +1,109 @@
+#include "SessionManager.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+
+SessionManager::SessionManager(size_t reserved, uint32_t pool, uint32_t poolCount)
+{
+	this->pool = pool;
+	this->poolCount = std::max(1u, poolCount);
+	openCount = 0;
+	while (slots.size() < reserved)
+	{
+		grow();
+	}
+	addFreeSlots(0);
+}
+
+SessionManager::SessionId SessionManager::open(void)
+{
+	if (freeSlots.empty())
+	{
+		size_t first = slots.size();
+		grow();
+		addFreeSlots(first);
+	}
+
+	uint32_t index = freeSlots.back();
+	freeSlots.pop_back();
+
+	Slot& slot = slots[index];
+	slot.open = true;
+	slot.game->reset();
+	openCount++;
+
+	return makeId(index, slot.generation);
+}
+
+Game* SessionManager::find(SessionId id)
+{
+	uint32_t index = slotOf(id);
+	if (index >= slots.size())
+	{
+		return nullptr;
+	}
+
+	const Slot& slot = slots[index];
+	return slot.open && slot.generation == uint32_t(id >> 32) ? slot.game : nullptr;
+}
+
+bool SessionManager::close(SessionId id)
+{
+	uint32_t index = slotOf(id);
+	if (index >= slots.size() || !slots[index].open || slots[index].generation != uint32_t(id >> 32))
+	{
+		return false;
+	}
+
+	// The game is reset when it is handed out again, not now
+	Slot& slot = slots[index];
+	slot.open = false;
+	slot.generation++;
+	freeSlots.push_back(index);
+	openCount--;
+	return true;
+}
+
+uint32_t SessionManager::poolOf(SessionId id, uint32_t poolCount)
+{
+	return (uint32_t(id & 0xFFFFFFFF) - 1) % std::max(1u, poolCount);
+}
+
+void SessionManager::grow(void)
+{
+	CHESS_ALLOC_SCOPE(GAME);
+
+	blocks.push_back(std::unique_ptr<Game[]>(new Game[BLOCK_SIZE]));
+	Game* games = blocks.back().get();
+
+	for (size_t i = 0; i < BLOCK_SIZE; i++)
+	{
+		Slot slot = { &games[i], 0, false };
+		slots.push_back(slot);
+	}
+}
+
+void SessionManager::addFreeSlots(size_t first)
+{
+	// Highest first, so the lower slots are handed out first
+	for (size_t i = slots.size(); i > first; i--)
+	{
+		freeSlots.push_back(uint32_t(i - 1));
+	}
+}
+
+uint32_t SessionManager::slotOf(SessionId id) const
+{
+	// The low half counts from 1, so INVALID_SESSION never matches
+	uint32_t index = uint32_t(id & 0xFFFFFFFF) - 1;
+	if (INVALID_SESSION == (id & 0xFFFFFFFF) || pool != index % poolCount)
+	{
+		return uint32_t(slots.size());
+	}
+	return index / poolCount;
+}
+
+SessionManager::SessionId SessionManager::makeId(uint32_t slot, uint32_t generation) const
+{
+	// The slots of the pools are interleaved: pool + 1, pool + 1 + poolCount, ...
+	return (SessionId(generation) << 32) | (SessionId(slot) * poolCount + pool + 1);
+}
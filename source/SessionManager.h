@@ -0,0 +1,71 @@
+#pragma once
+#include "includes.h"
+#include "game.h"
+#include <memory>
+
+// Hosts many games at once, each one under a session ID. The games live in
+// blocks of BLOCK_SIZE that are never freed or moved: a closed session puts
+// its game back on a free list and the next session resets it in place, so
+// after warming up, opening and closing sessions allocates nothing and the
+// memory stays flat at the peak number of games.
+// An ID holds the slot of the game and a generation counter, so looking one up
+// is an array access and an ID of a closed session is never mistaken for a
+// newer one in the same slot. A manager takes no lock: it belongs to one
+// thread. Several threads each keep their own pool, one of the pool count, and
+// the pool is part of its IDs, so any ID tells which thread owns the game
+class SessionManager
+{
+public:
+	typedef uint64_t SessionId;
+
+	static const SessionId INVALID_SESSION = 0;
+
+	// Games allocated together
+	static const size_t BLOCK_SIZE = 64;
+
+	// At least this many sessions can be opened without allocating
+	explicit SessionManager(size_t reserved = 0, uint32_t pool = 0, uint32_t poolCount = 1);
+
+	// Starts a new game in its initial position
+	SessionId open(void);
+
+	// The game of an open session, nullptr for an unknown or closed one, or one of another pool
+	Game* find(SessionId id);
+
+	// The game goes back to the pool. False when the session was not open
+	bool close(SessionId id);
+
+	size_t getOpenCount(void) const { return openCount; }
+
+	// Games allocated so far, open or pooled
+	size_t getCapacity(void) const { return slots.size(); }
+
+	// The pool that opened the session, out of poolCount
+	static uint32_t poolOf(SessionId id, uint32_t poolCount);
+
+private:
+	struct Slot
+	{
+		Game*    game;
+		uint32_t generation; // Changes every time the slot is closed
+		bool     open;
+	};
+
+	uint32_t pool;
+	uint32_t poolCount;
+	std::vector<std::unique_ptr<Game[]> > blocks;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	size_t openCount;
+
+	// Adds one block of games to the pool, its slots are not free yet
+	void grow(void);
+
+	// Puts the slots from first to the last one on the free list
+	void addFreeSlots(size_t first);
+
+	// The slot of a session of this pool, slots.size() for any other ID
+	uint32_t slotOf(SessionId id) const;
+
+	SessionId makeId(uint32_t slot, uint32_t generation) const;
+};
@@ -0,0 +1,61 @@
+#include "Sprt.h"
+#include <cmath>
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta)
+	: elo0(elo0), elo1(elo1)
+{
+	lowerBound = std::log(beta / (1.0 - alpha));
+	upperBound = std::log((1.0 - beta) / alpha);
+}
+
+double Sprt::llr(int wins, int draws, int losses) const
+{
+	int games = wins + draws + losses;
+	if (0 == games)
+	{
+		return 0.0;
+	}
+
+	double score = (wins + 0.5 * draws) / games;
+	double variance = (wins * (1.0 - score) * (1.0 - score) + draws * (0.5 - score) * (0.5 - score) + losses * score * score) / games;
+
+	// Nothing can be said until the results differ at least once
+	if (variance <= 0.0)
+	{
+		return 0.0;
+	}
+
+	double score0 = eloToScore(elo0);
+	double score1 = eloToScore(elo1);
+
+	return games * (score1 - score0) * (2.0 * score - score0 - score1) / (2.0 * variance);
+}
+
+Sprt::Decision Sprt::decide(int wins, int draws, int losses) const
+{
+	double ratio = llr(wins, draws, losses);
+
+	if (ratio >= upperBound)
+	{
+		return ACCEPT_H1;
+	}
+	if (ratio <= lowerBound)
+	{
+		return ACCEPT_H0;
+	}
+	return CONTINUE;
+}
+
+double Sprt::scoreToElo(double score)
+{
+	if (score <= 0.0 || score >= 1.0)
+	{
+		return score <= 0.0 ? -INFINITY : INFINITY;
+	}
+	return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double Sprt::eloToScore(double elo)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
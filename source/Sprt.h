@@ -0,0 +1,37 @@
+#pragma once
+#include "includes.h"
+
+// Sequential probability ratio test on the game results of a match.
+// H0: the Elo difference is elo0, H1: it is elo1. The log-likelihood ratio
+// uses the normal approximation of the score (the "GSPRT" of fishtest), so
+// draws are taken into account without having to model a draw Elo
+class Sprt
+{
+public:
+	enum Decision
+	{
+		CONTINUE = 0,
+		ACCEPT_H0,
+		ACCEPT_H1
+	};
+
+	Sprt(double elo0, double elo1, double alpha = 0.05, double beta = 0.05);
+
+	double llr(int wins, int draws, int losses) const;
+
+	Decision decide(int wins, int draws, int losses) const;
+
+	double getLowerBound(void) const { return lowerBound; }
+	double getUpperBound(void) const { return upperBound; }
+
+	// Elo difference for an average score between 0 and 1
+	static double scoreToElo(double score);
+
+	static double eloToScore(double elo);
+
+private:
+	double elo0;
+	double elo1;
+	double lowerBound;
+	double upperBound;
+};
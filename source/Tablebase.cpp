@@ -0,0 +1,868 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	const char EMPTY = Chess::EMPTY_FIELD;
+
+	// Non-king pieces from the strongest down
+	const char PIECE_ORDER[] = "QRBNP";
+
+	const char MAGIC[4] = { 'C', 'H', 'T', 'B' };
+	const char VERSION = 1;
+	const size_t HEADER_SIZE = 16;
+
+	// Squares of the white king in a pawnless table: a1-d1-d4
+	const int TRIANGLE[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+	const int KING_STEPS[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	const int KNIGHT_STEPS[8][2] = { { 2, 1 }, { 1, 2 }, { -1, 2 }, { -2, 1 }, { -2, -1 }, { -1, -2 }, { 1, -2 }, { 2, -1 } };
+
+	int pieceRank(char piece)
+	{
+		return int(strchr(PIECE_ORDER, toupper(piece)) - PIECE_ORDER);
+	}
+
+	bool isKing(char piece)
+	{
+		return Chess::PIECE_TYPE_KING == (piece & ~0x20);
+	}
+
+	// Bit 0 mirrors the files, bit 1 the rows and bit 2 the a1-h8 diagonal
+	int transform(int square, int symmetry)
+	{
+		if (symmetry & 1)
+		{
+			square ^= 7;
+		}
+		if (symmetry & 2)
+		{
+			square ^= 56;
+		}
+		if (symmetry & 4)
+		{
+			square = ((square & 7) << 3) | (square >> 3);
+		}
+		return square;
+	}
+
+	// Plies to mate of a won or lost value
+	int distanceOf(int value)
+	{
+		return value > 0 ? value : -value - 1;
+	}
+
+	void makeHeader(const std::string& signature, char header[HEADER_SIZE])
+	{
+		memset(header, 0, HEADER_SIZE);
+		memcpy(header, MAGIC, sizeof(MAGIC));
+		header[4] = VERSION;
+		memcpy(header + 8, signature.c_str(), std::min(signature.size(), HEADER_SIZE - 8));
+	}
+
+	std::string pathOf(const std::string& directory, const std::string& signature)
+	{
+		return (directory.empty() ? string(".") : directory) + "/" + signature + ".tb";
+	}
+
+	// Hands out [0, count) to the threads in blocks, so that slow ranges don't hold the others up
+	void parallel(int threads, size_t count, const std::function<void(int thread, size_t begin, size_t end)>& work)
+	{
+		const size_t BLOCK = 4096;
+		std::atomic<size_t> next(0);
+		std::vector<std::thread> pool;
+
+		for (int i = 0; i < threads; i++)
+		{
+			pool.push_back(std::thread([&, i]()
+			{
+				for (size_t begin = next.fetch_add(BLOCK); begin < count; begin = next.fetch_add(BLOCK))
+				{
+					work(i, begin, std::min(count, begin + BLOCK));
+				}
+			}));
+		}
+		for (size_t i = 0; i < pool.size(); i++)
+		{
+			pool[i].join();
+		}
+	}
+}
+
+Tablebase::Tablebase(const std::string& signature) : signature(signature), pieceCount(0), hasPawns(false), kingSquares(0), size(0), values(nullptr)
+{
+	std::vector<std::string> all = Tablebases::allSignatures();
+	if (all.end() == std::find(all.begin(), all.end(), signature))
+	{
+		throw invalid_argument("No tablebase for " + signature + "\n");
+	}
+
+	size_t second = signature.find(Chess::PIECE_TYPE_KING, 1);
+	pieces[pieceCount++] = Chess::PIECE_TYPE_KING;
+	pieces[pieceCount++] = Chess::PIECE_TYPE_KING_LOW;
+	for (size_t i = 1; i < signature.size(); i++)
+	{
+		if (i != second)
+		{
+			pieces[pieceCount++] = i < second ? signature[i] : char(tolower(signature[i]));
+		}
+	}
+
+	hasPawns = string::npos != signature.find(Chess::PIECE_TYPE_PAWN);
+	kingSquares = hasPawns ? 32 : 10;
+	size = 2 * kingSquares;
+	for (int i = 1; i < pieceCount; i++)
+	{
+		size *= 64;
+	}
+}
+
+size_t Tablebase::indexOf(const Board& board) const
+{
+	int squares[MAX_PIECES] = { board.kingSquare[Chess::WHITE_PLAYER], board.kingSquare[Chess::BLACK_PLAYER], -1, -1 };
+
+	for (int square = 0; square < 64; square++)
+	{
+		char piece = board.squares[square];
+		if (EMPTY == piece || isKing(piece))
+		{
+			continue;
+		}
+		for (int i = 2; i < pieceCount; i++)
+		{
+			if (pieces[i] == piece && squares[i] < 0)
+			{
+				squares[i] = square;
+				break;
+			}
+		}
+	}
+
+	// Bring the white king into its part of the board
+	int symmetry = 0;
+	int king = squares[0];
+	if (Board::columnOf(king) > 3)
+	{
+		symmetry |= 1;
+		king ^= 7;
+	}
+	if (!hasPawns)
+	{
+		if (Board::rowOf(king) > 3)
+		{
+			symmetry |= 2;
+			king ^= 56;
+		}
+		if (Board::rowOf(king) > Board::columnOf(king))
+		{
+			symmetry |= 4;
+		}
+		else if (Board::rowOf(king) == Board::columnOf(king))
+		{
+			// On the diagonal both ways round are in the triangle: the smaller index is the position's
+			return std::min(encode(board.sideToMove, squares, symmetry), encode(board.sideToMove, squares, symmetry | 4));
+		}
+	}
+
+	return encode(board.sideToMove, squares, symmetry);
+}
+
+size_t Tablebase::encode(int sideToMove, const int squares[MAX_PIECES], int symmetry) const
+{
+	int moved[MAX_PIECES];
+	for (int i = 0; i < pieceCount; i++)
+	{
+		moved[i] = transform(squares[i], symmetry);
+	}
+	if (MAX_PIECES == pieceCount && pieces[2] == pieces[3] && moved[2] > moved[3])
+	{
+		std::swap(moved[2], moved[3]);
+	}
+
+	int kingIndex = 0;
+	if (hasPawns)
+	{
+		kingIndex = Board::rowOf(moved[0]) * 4 + Board::columnOf(moved[0]);
+	}
+	else
+	{
+		while (TRIANGLE[kingIndex] != moved[0])
+		{
+			kingIndex++;
+		}
+	}
+
+	size_t index = sideToMove * kingSquares + kingIndex;
+	for (int i = 1; i < pieceCount; i++)
+	{
+		index = index * 64 + moved[i];
+	}
+	return index;
+}
+
+bool Tablebase::decode(size_t index, Board& board) const
+{
+	int squares[MAX_PIECES];
+	size_t rest = index;
+	for (int i = pieceCount - 1; i > 0; i--)
+	{
+		squares[i] = int(rest % 64);
+		rest /= 64;
+	}
+	int kingIndex = int(rest % kingSquares);
+	int side = int(rest / kingSquares);
+	squares[0] = hasPawns ? Board::makeSquare(kingIndex / 4, kingIndex % 4) : TRIANGLE[kingIndex];
+
+	memset(board.squares, EMPTY, sizeof(board.squares));
+	for (int i = 0; i < pieceCount; i++)
+	{
+		int row = Board::rowOf(squares[i]);
+		if (EMPTY != board.squares[squares[i]] || (Chess::PIECE_TYPE_PAWN == toupper(pieces[i]) && (0 == row || 7 == row)))
+		{
+			return false;
+		}
+		board.squares[squares[i]] = pieces[i];
+	}
+
+	if (abs(Board::rowOf(squares[0]) - Board::rowOf(squares[1])) <= 1 && abs(Board::columnOf(squares[0]) - Board::columnOf(squares[1])) <= 1)
+	{
+		return false;
+	}
+
+	board.sideToMove = side;
+	board.castlingRights = 0;
+	board.enPassantSquare = Board::NO_SQUARE;
+	board.halfmoveClock = 0;
+	board.fullmoveNumber = 1;
+	board.kingSquare[Chess::WHITE_PLAYER] = squares[0];
+	board.kingSquare[Chess::BLACK_PLAYER] = squares[1];
+
+	// The side that just moved can't be in check
+	if (board.isSquareAttacked(board.kingSquare[side ^ 1], side))
+	{
+		return false;
+	}
+
+	// Each position has one index: equal pieces in square order, and the smaller one on the diagonal
+	if (indexOf(board) != index)
+	{
+		return false;
+	}
+
+	board.hash = board.computeHash();
+	return true;
+}
+
+std::vector<std::string> Tablebase::dependencies(void) const
+{
+	std::vector<std::string> all = Tablebases::allSignatures();
+	std::vector<std::string> result;
+	size_t second = signature.find(Chess::PIECE_TYPE_KING, 1);
+
+	auto add = [&](const std::string& material)
+	{
+		bool swapped;
+		std::string name = Tablebases::canonical(material, swapped);
+		if (all.end() != std::find(all.begin(), all.end(), name) && result.end() == std::find(result.begin(), result.end(), name))
+		{
+			result.push_back(name);
+		}
+	};
+
+	for (size_t i = 0; i < signature.size(); i++)
+	{
+		if (Chess::PIECE_TYPE_KING == signature[i])
+		{
+			continue;
+		}
+
+		std::string captured = signature;
+		captured.erase(i, 1);
+		add(captured);
+
+		if (Chess::PIECE_TYPE_PAWN == signature[i])
+		{
+			for (int promotion = 0; promotion < 4; promotion++)
+			{
+				std::string promoted = signature;
+				promoted[i] = PIECE_ORDER[promotion];
+				add(promoted);
+
+				// Promoting with a capture
+				for (size_t j = 0; j < signature.size(); j++)
+				{
+					if (Chess::PIECE_TYPE_KING != signature[j] && (i < second) != (j < second))
+					{
+						std::string both = promoted;
+						both.erase(j, 1);
+						add(both);
+					}
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+void Tablebase::generate(const Tablebases& smaller, int threads, std::ostream& out)
+{
+	std::vector<std::string> needed = dependencies();
+	for (size_t i = 0; i < needed.size(); i++)
+	{
+		if (nullptr == smaller.find(needed[i]))
+		{
+			throw invalid_argument(signature + " needs the " + needed[i] + " table\n");
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	threads = std::max(1, threads);
+	file.close();
+	generated.assign(size, int8_t(UNKNOWN));
+	values = &generated[0];
+
+	struct Found
+	{
+		uint32_t index;
+		int8_t   value;
+	};
+
+	// Values are only written between the passes, from the lists of the threads
+	std::vector<std::vector<Found> > found(threads);
+	std::vector<std::vector<uint32_t> > buckets(MAX_PLIES + 1);
+	std::vector<uint32_t> published;
+	std::vector<uint32_t> invalid;
+	std::mutex invalidMutex;
+
+	auto apply = [&](int pass)
+	{
+		published.clear();
+		for (int thread = 0; thread < threads; thread++)
+		{
+			for (size_t i = 0; i < found[thread].size(); i++)
+			{
+				const Found& result = found[thread][i];
+				int distance = distanceOf(result.value);
+				if (distance <= pass)
+				{
+					generated[result.index] = result.value;
+					published.push_back(result.index);
+				}
+				else
+				{
+					buckets[distance].push_back(result.index);
+				}
+			}
+			found[thread].clear();
+		}
+	};
+
+	// Pass 0 looks at every position: mates, and values that only depend on the smaller tables
+	parallel(threads, size, [&](int thread, size_t begin, size_t end)
+	{
+		std::vector<uint32_t> bad;
+		Board board;
+		for (size_t index = begin; index < end; index++)
+		{
+			if (!decode(index, board))
+			{
+				bad.push_back(uint32_t(index));
+				continue;
+			}
+			int value = examine(board, smaller);
+			if (UNKNOWN != value)
+			{
+				Found result = { uint32_t(index), int8_t(value) };
+				found[thread].push_back(result);
+			}
+		}
+		std::lock_guard<std::mutex> lock(invalidMutex);
+		invalid.insert(invalid.end(), bad.begin(), bad.end());
+	});
+	for (size_t i = 0; i < invalid.size(); i++)
+	{
+		generated[invalid[i]] = INVALID;
+	}
+	apply(0);
+
+	// Pass N settles the positions that are mated or mate in N plies. Only the
+	// positions that lead to one settled in pass N - 1 can change, plus those
+	// an earlier pass found a longer way out of the table for
+	int pass = 1;
+	for (; pass <= MAX_PLIES; pass++)
+	{
+		bool pending = !published.empty();
+		for (int later = pass; later <= MAX_PLIES && !pending; later++)
+		{
+			pending = !buckets[later].empty();
+		}
+		if (!pending)
+		{
+			break;
+		}
+
+		std::vector<std::vector<uint32_t> > predecessors(threads);
+		parallel(threads, published.size(), [&](int thread, size_t begin, size_t end)
+		{
+			Board board;
+			for (size_t i = begin; i < end; i++)
+			{
+				decode(published[i], board);
+				addPredecessors(board, predecessors[thread]);
+			}
+		});
+
+		std::vector<uint32_t> candidates;
+		candidates.swap(buckets[pass]);
+		for (int thread = 0; thread < threads; thread++)
+		{
+			candidates.insert(candidates.end(), predecessors[thread].begin(), predecessors[thread].end());
+		}
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		parallel(threads, candidates.size(), [&](int thread, size_t begin, size_t end)
+		{
+			Board board;
+			for (size_t i = begin; i < end; i++)
+			{
+				if (UNKNOWN != generated[candidates[i]])
+				{
+					continue;
+				}
+				decode(candidates[i], board);
+				int value = examine(board, smaller);
+				if (UNKNOWN != value)
+				{
+					Found result = { candidates[i], int8_t(value) };
+					found[thread].push_back(result);
+				}
+			}
+		});
+		apply(pass);
+	}
+
+	// Everything else is a draw
+	size_t counts[3] = { 0, 0, 0 };
+	int longest = 0;
+	for (size_t index = 0; index < size; index++)
+	{
+		int8_t& value = generated[index];
+		if (INVALID == value || UNKNOWN == value)
+		{
+			counts[1] += UNKNOWN == value;
+			value = DRAW;
+		}
+		else
+		{
+			counts[value > 0 ? 0 : 2]++;
+			longest = std::max(longest, distanceOf(value));
+		}
+	}
+
+	out << signature << ": " << counts[0] + counts[1] + counts[2] << " positions, " << counts[0] << " won, " << counts[1] << " drawn, "
+		<< counts[2] << " lost, longest mate " << longest << " plies, " << pass - 1 << " passes, "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+}
+
+int Tablebase::examine(const Board& board, const Tablebases& smaller) const
+{
+	Board::MoveList list;
+	board.generateMoves(list);
+
+	int fastestWin = MAX_PLIES + 1;
+	int slowestLoss = 0;
+	bool allLose = true;
+	bool hasMoves = false;
+
+	for (int i = 0; i < list.count; i++)
+	{
+		const CompactMove& move = list.moves[i];
+		Board next = board;
+		if (!next.makeMove(move))
+		{
+			continue;
+		}
+		hasMoves = true;
+
+		int value = successorValue(next, move.isCapture() || 0 != move.promotion, smaller);
+		if (value < 0)
+		{
+			fastestWin = std::min(fastestWin, distanceOf(value) + 1);
+		}
+		else if (value > 0 && UNKNOWN != value)
+		{
+			slowestLoss = std::max(slowestLoss, value + 1);
+		}
+		else
+		{
+			allLose = false;
+		}
+	}
+
+	if (!hasMoves)
+	{
+		// Stalemate stays unknown and ends up a draw
+		return board.isInCheck() ? -1 : UNKNOWN;
+	}
+
+	// Mates too long for a byte are left as draws
+	if (fastestWin <= MAX_PLIES)
+	{
+		return fastestWin;
+	}
+	if (allLose && slowestLoss <= MAX_PLIES)
+	{
+		return -slowestLoss - 1;
+	}
+	return UNKNOWN;
+}
+
+int Tablebase::successorValue(const Board& next, bool leftTable, const Tablebases& smaller) const
+{
+	if (!leftTable)
+	{
+		return generated[indexOf(next)];
+	}
+	if (next.isInsufficientMaterial())
+	{
+		return DRAW;
+	}
+
+	int value = DRAW;
+	smaller.probe(next, value);
+	return value;
+}
+
+void Tablebase::addPredecessors(const Board& board, std::vector<uint32_t>& out) const
+{
+	int moved = board.sideToMove ^ 1;
+
+	for (int square = 0; square < 64; square++)
+	{
+		char piece = board.squares[square];
+		if (EMPTY == piece || (Chess::WHITE_PLAYER == moved) != (0 != isupper(piece)))
+		{
+			continue;
+		}
+
+		int row = Board::rowOf(square);
+		int column = Board::columnOf(square);
+		char type = char(toupper(piece));
+
+		auto add = [&](int origin)
+		{
+			Board previous = board;
+			previous.squares[origin] = piece;
+			previous.squares[square] = EMPTY;
+			previous.sideToMove = moved;
+			if (Chess::PIECE_TYPE_KING == type)
+			{
+				const int other = previous.kingSquare[moved ^ 1];
+				if (abs(Board::rowOf(origin) - Board::rowOf(other)) <= 1 && abs(Board::columnOf(origin) - Board::columnOf(other)) <= 1)
+				{
+					return;
+				}
+				previous.kingSquare[moved] = origin;
+			}
+
+			// The side to move now must not have been in check before the move
+			if (previous.isSquareAttacked(previous.kingSquare[moved ^ 1], moved))
+			{
+				return;
+			}
+
+			size_t index = indexOf(previous);
+			if (UNKNOWN == generated[index])
+			{
+				out.push_back(uint32_t(index));
+			}
+		};
+
+		auto addSteps = [&](const int steps[8][2])
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				int toRow = row + steps[i][0];
+				int toColumn = column + steps[i][1];
+				if (toRow >= 0 && toRow < 8 && toColumn >= 0 && toColumn < 8 && EMPTY == board.squares[Board::makeSquare(toRow, toColumn)])
+				{
+					add(Board::makeSquare(toRow, toColumn));
+				}
+			}
+		};
+
+		switch (type)
+		{
+		case Chess::PIECE_TYPE_KING:
+			addSteps(KING_STEPS);
+			break;
+
+		case Chess::PIECE_TYPE_KNIGHT:
+			addSteps(KNIGHT_STEPS);
+			break;
+
+		case Chess::PIECE_TYPE_PAWN:
+		{
+			// One row back, or two back to the starting row. A pawn never comes from a promotion
+			int back = Chess::WHITE_PLAYER == moved ? -1 : 1;
+			int startRow = Chess::WHITE_PLAYER == moved ? 1 : 6;
+			int oneBack = square + 8 * back;
+			if (row + back >= 1 && row + back <= 6 && EMPTY == board.squares[oneBack])
+			{
+				add(oneBack);
+				if (row == startRow - 2 * back && EMPTY == board.squares[oneBack + 8 * back])
+				{
+					add(oneBack + 8 * back);
+				}
+			}
+			break;
+		}
+
+		default:
+			for (int i = 0; i < 8; i++)
+			{
+				bool diagonal = 0 != KING_STEPS[i][0] && 0 != KING_STEPS[i][1];
+				if ((Chess::PIECE_TYPE_ROOK == type && diagonal) || (Chess::PIECE_TYPE_BISHOP == type && !diagonal))
+				{
+					continue;
+				}
+
+				int toRow = row + KING_STEPS[i][0];
+				int toColumn = column + KING_STEPS[i][1];
+				while (toRow >= 0 && toRow < 8 && toColumn >= 0 && toColumn < 8 && EMPTY == board.squares[Board::makeSquare(toRow, toColumn)])
+				{
+					add(Board::makeSquare(toRow, toColumn));
+					toRow += KING_STEPS[i][0];
+					toColumn += KING_STEPS[i][1];
+				}
+			}
+			break;
+		}
+	}
+}
+
+bool Tablebase::save(const std::string& fileName) const
+{
+	if (nullptr == values)
+	{
+		return false;
+	}
+
+	char header[HEADER_SIZE];
+	makeHeader(signature, header);
+
+	std::ofstream output(fileName, std::ios::binary);
+	output.write(header, HEADER_SIZE);
+	output.write(reinterpret_cast<const char*>(values), size);
+	return output.good();
+}
+
+bool Tablebase::load(const std::string& fileName)
+{
+	if (!file.open(fileName))
+	{
+		return false;
+	}
+
+	char header[HEADER_SIZE];
+	makeHeader(signature, header);
+	if (HEADER_SIZE + size != file.getSize() || 0 != memcmp(header, file.getData(), HEADER_SIZE))
+	{
+		file.close();
+		return false;
+	}
+
+	generated.clear();
+	generated.shrink_to_fit();
+	values = reinterpret_cast<const int8_t*>(file.getData() + HEADER_SIZE);
+	return true;
+}
+
+std::vector<std::string> Tablebases::allSignatures(void)
+{
+	std::vector<std::string> result;
+	const string king(1, Chess::PIECE_TYPE_KING);
+
+	// A single bishop or knight can't mate
+	for (int a = 0; a < 5; a++)
+	{
+		if (Chess::PIECE_TYPE_BISHOP != PIECE_ORDER[a] && Chess::PIECE_TYPE_KNIGHT != PIECE_ORDER[a])
+		{
+			result.push_back(king + PIECE_ORDER[a] + king);
+		}
+	}
+	for (int a = 0; a < 5; a++)
+	{
+		for (int b = a; b < 5; b++)
+		{
+			result.push_back(king + PIECE_ORDER[a] + PIECE_ORDER[b] + king);
+		}
+	}
+	for (int a = 0; a < 5; a++)
+	{
+		for (int b = a; b < 5; b++)
+		{
+			result.push_back(king + PIECE_ORDER[a] + king + PIECE_ORDER[b]);
+		}
+	}
+
+	return result;
+}
+
+std::string Tablebases::canonical(const std::string& signature, bool& swapped)
+{
+	swapped = false;
+
+	std::string text = signature;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		text[i] = char(toupper(text[i]));
+	}
+
+	size_t second = text.find(Chess::PIECE_TYPE_KING, 1);
+	if (text.size() < 3 || text.size() > size_t(Tablebase::MAX_PIECES) || Chess::PIECE_TYPE_KING != text[0] || string::npos == second)
+	{
+		return "";
+	}
+
+	// Each side as piece ranks, strongest first, so that comparing the strings compares the material
+	std::string sides[2] = { text.substr(1, second - 1), text.substr(second + 1) };
+	for (int side = 0; side < 2; side++)
+	{
+		for (size_t i = 0; i < sides[side].size(); i++)
+		{
+			char piece = sides[side][i];
+			if (Chess::PIECE_TYPE_KING == piece || nullptr == strchr(PIECE_ORDER, piece) || 0 == piece)
+			{
+				return "";
+			}
+			sides[side][i] = char('0' + pieceRank(piece));
+		}
+		std::sort(sides[side].begin(), sides[side].end());
+	}
+
+	swapped = sides[1].size() > sides[0].size() || (sides[1].size() == sides[0].size() && sides[1] < sides[0]);
+	if (swapped)
+	{
+		std::swap(sides[0], sides[1]);
+	}
+
+	std::string result;
+	for (int side = 0; side < 2; side++)
+	{
+		result += Chess::PIECE_TYPE_KING;
+		for (size_t i = 0; i < sides[side].size(); i++)
+		{
+			result += PIECE_ORDER[sides[side][i] - '0'];
+		}
+	}
+	return result;
+}
+
+int Tablebases::load(const std::string& directory)
+{
+	int loaded = 0;
+	std::vector<std::string> all = allSignatures();
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		std::unique_ptr<Tablebase> table(new Tablebase(all[i]));
+		if (table->load(pathOf(directory, all[i])))
+		{
+			tables[all[i]] = std::move(table);
+			loaded++;
+		}
+	}
+	return loaded;
+}
+
+void Tablebases::generate(const std::string& signature, int threads, std::ostream& out, const std::string& directory)
+{
+	bool swapped;
+	std::string name = canonical(signature, swapped);
+	if (name.empty())
+	{
+		throw invalid_argument("Invalid material " + signature + "\n");
+	}
+	if (tables.count(name))
+	{
+		return;
+	}
+
+	std::unique_ptr<Tablebase> table(new Tablebase(name));
+	std::vector<std::string> needed = table->dependencies();
+	for (size_t i = 0; i < needed.size(); i++)
+	{
+		generate(needed[i], threads, out, directory);
+	}
+
+	table->generate(*this, threads, out);
+	if (!directory.empty() && !table->save(pathOf(directory, name)))
+	{
+		throw invalid_argument("Error saving " + pathOf(directory, name) + "\n");
+	}
+	tables[name] = std::move(table);
+}
+
+const Tablebase* Tablebases::find(const std::string& signature) const
+{
+	auto found = tables.find(signature);
+	return tables.end() == found ? nullptr : found->second.get();
+}
+
+bool Tablebases::probe(const Board& board, int& value) const
+{
+	if (tables.empty() || 0 != board.castlingRights || Board::NO_SQUARE != board.enPassantSquare)
+	{
+		return false;
+	}
+
+	std::string sides[2] = { string(1, Chess::PIECE_TYPE_KING), string(1, Chess::PIECE_TYPE_KING) };
+	int count = 0;
+	for (int square = 0; square < 64; square++)
+	{
+		char piece = board.squares[square];
+		if (EMPTY == piece)
+		{
+			continue;
+		}
+		if (++count > Tablebase::MAX_PIECES)
+		{
+			return false;
+		}
+		if (!isKing(piece))
+		{
+			sides[isupper(piece) ? Chess::WHITE_PLAYER : Chess::BLACK_PLAYER] += char(toupper(piece));
+		}
+	}
+
+	bool swapped;
+	const Tablebase* table = find(canonical(sides[0] + sides[1], swapped));
+	if (nullptr == table)
+	{
+		return false;
+	}
+	if (!swapped)
+	{
+		value = table->probe(board);
+		return true;
+	}
+
+	// Same position with the colors exchanged, so that the stronger side is white
+	Board mirrored = board;
+	for (int square = 0; square < 64; square++)
+	{
+		char piece = board.squares[square];
+		mirrored.squares[square ^ 56] = EMPTY == piece ? piece : char(piece ^ 0x20);
+	}
+	mirrored.sideToMove = board.sideToMove ^ 1;
+	mirrored.kingSquare[Chess::WHITE_PLAYER] = board.kingSquare[Chess::BLACK_PLAYER] ^ 56;
+	mirrored.kingSquare[Chess::BLACK_PLAYER] = board.kingSquare[Chess::WHITE_PLAYER] ^ 56;
+	value = table->probe(mirrored);
+	return true;
+}
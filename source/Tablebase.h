@@ -0,0 +1,111 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+#include "MappedFile.h"
+#include <map>
+#include <memory>
+
+class Tablebases;
+
+// Endgame table for one material signature, e.g. "KQKR": the white pieces,
+// then the black ones, the stronger side always as white. It holds the exact
+// distance to mate of every position, found by retrograde analysis.
+//
+// A position's index is side to move, white king, black king and the other
+// pieces in signature order. The board is first mirrored so the white king
+// stands in the a1-d1-d4 triangle (or on files a-d when there are pawns),
+// which makes pawnless tables 6.4 times and the others 2 times smaller.
+// Castling and en passant are ignored
+class Tablebase
+{
+public:
+	static const int MAX_PIECES = 4;
+
+	// Values are one byte, from the point of view of the side to move:
+	// 0 is a draw, +N wins with mate in N plies, -(N + 1) gets mated in N plies
+	static const int DRAW = 0;
+	static const int MAX_PLIES = 126;
+
+	// Throws invalid_argument if the signature is not one of allSignatures()
+	explicit Tablebase(const std::string& signature);
+
+	const std::string& getSignature(void) const { return signature; }
+
+	size_t getSize(void) const { return size; }
+
+	// Signatures of the tables that captures and promotions lead to
+	std::vector<std::string> dependencies(void) const;
+
+	// Throws invalid_argument if one of dependencies() is not in "smaller"
+	void generate(const Tablebases& smaller, int threads, std::ostream& out);
+
+	bool save(const std::string& fileName) const;
+
+	// Memory-maps a file written by save()
+	bool load(const std::string& fileName);
+
+	// The board must have exactly this material, with the stronger side as white
+	int probe(const Board& board) const { return values[indexOf(board)]; }
+
+	size_t indexOf(const Board& board) const;
+
+	// False for indexes that are not a legal position, or not in their canonical form
+	bool decode(size_t index, Board& board) const;
+
+private:
+	static const int8_t UNKNOWN = 127;
+	static const int8_t INVALID = -128;
+
+	std::string signature;
+	char pieces[MAX_PIECES]; // White king, black king, then the other pieces with their color
+	int pieceCount;
+	bool hasPawns;
+	int kingSquares;         // 10 squares in the triangle, 32 with pawns
+	size_t size;
+
+	std::vector<int8_t> generated;
+	MappedFile file;
+	const int8_t* values;
+
+	size_t encode(int sideToMove, const int squares[MAX_PIECES], int symmetry) const;
+
+	// Value found from the successors that are known so far, UNKNOWN if there is none yet
+	int examine(const Board& board, const Tablebases& smaller) const;
+
+	// Value of the position after a move, from its side to move
+	int successorValue(const Board& next, bool leftTable, const Tablebases& smaller) const;
+
+	// Positions the side that just moved could have come from, without a capture or promotion
+	void addPredecessors(const Board& board, std::vector<uint32_t>& out) const;
+
+	Tablebase(const Tablebase&);
+	Tablebase& operator=(const Tablebase&);
+};
+
+// All the tables that are loaded or generated, probed by material
+class Tablebases
+{
+public:
+	// Every 3 and 4 piece signature that can be mated, stronger side first
+	static std::vector<std::string> allSignatures(void);
+
+	// "KRKQ" becomes "KQKR" with swapped set; empty if it is not a valid signature
+	static std::string canonical(const std::string& signature, bool& swapped);
+
+	// Loads every <signature>.tb found in the directory and returns how many
+	int load(const std::string& directory);
+
+	// Generates the table and, first, those its captures and promotions lead to.
+	// Tables that are already there are kept. New ones are saved to the directory unless it is empty
+	void generate(const std::string& signature, int threads, std::ostream& out, const std::string& directory);
+
+	bool isEmpty(void) const { return tables.empty(); }
+
+	const Tablebase* find(const std::string& signature) const;
+
+	// Distance to mate from the side to move (see Tablebase), false when there is no table
+	bool probe(const Board& board, int& value) const;
+
+private:
+	std::map<std::string, std::unique_ptr<Tablebase> > tables;
+};
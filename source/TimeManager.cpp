@@ -0,0 +1,125 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+SearchLimits::SearchLimits()
+{
+	depth = 0;
+	nodes = 0;
+	moveTime = 0;
+	time[Chess::WHITE_PLAYER] = 0;
+	time[Chess::BLACK_PLAYER] = 0;
+	increment[Chess::WHITE_PLAYER] = 0;
+	increment[Chess::BLACK_PLAYER] = 0;
+	movesToGo = 0;
+	infinite = false;
+	ponder = false;
+}
+
+TimeManager::TimeManager()
+{
+	moveOverhead = DEFAULT_MOVE_OVERHEAD;
+	hasDeadline = false;
+	clockControlled = false;
+	optimumTime = 0;
+	maximumTime = 0;
+	nodeLimit = UINT64_MAX;
+	lastBestMove = CompactMove::null();
+	lastScore = 0;
+	stableIterations = 0;
+}
+
+void TimeManager::start(const SearchLimits& limits, int sideToMove)
+{
+	startTime = std::chrono::steady_clock::now();
+
+	hasDeadline = false;
+	clockControlled = false;
+	optimumTime = 0;
+	maximumTime = 0;
+	nodeLimit = limits.nodes > 0 ? limits.nodes : UINT64_MAX;
+
+	lastBestMove = CompactMove::null();
+	lastScore = 0;
+	stableIterations = 0;
+
+	if (limits.infinite)
+	{
+		return;
+	}
+
+	if (limits.moveTime > 0)
+	{
+		// Fixed time per move: use all of it, minus the overhead
+		hasDeadline = true;
+		maximumTime = std::max(1, limits.moveTime - moveOverhead);
+		optimumTime = maximumTime;
+	}
+	else if (limits.usesClock(sideToMove))
+	{
+		hasDeadline = true;
+		clockControlled = true;
+
+		long long timeLeft = limits.time[sideToMove];
+		long long increment = limits.increment[sideToMove];
+
+		// Without a time control in sight, assume the game lasts this many more moves
+		long long movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, 50) : 30;
+
+		// Everything we can spend until the next time control, overhead paid for every move
+		long long available = timeLeft + increment * (movesToGo - 1) - moveOverhead * movesToGo;
+		available = std::max(available, 1LL);
+
+		optimumTime = available / movesToGo;
+
+		// The hard limit may go well over the average, but never close to a flag fall
+		long long safeLimit = timeLeft - moveOverhead;
+		if (movesToGo > 1)
+		{
+			safeLimit = std::min(safeLimit, timeLeft * 3 / 4);
+		}
+		maximumTime = std::min(optimumTime * 5, safeLimit);
+
+		maximumTime = std::max(maximumTime, 1LL);
+		optimumTime = std::max(std::min(optimumTime, maximumTime), 1LL);
+	}
+}
+
+bool TimeManager::shouldStopAfterIteration(int depth, const CompactMove& bestMove, int score)
+{
+	if (bestMove == lastBestMove)
+	{
+		stableIterations++;
+	}
+	else
+	{
+		stableIterations = 0;
+	}
+
+	bool scoreDropped = depth > 1 && score < lastScore - 30;
+
+	lastBestMove = bestMove;
+	lastScore = score;
+
+	if (!clockControlled)
+	{
+		// Fixed move time, depth or nodes: only the hard limits apply
+		return false;
+	}
+
+	// A best move that keeps changing (or a falling score) earns more time,
+	// a stable one less. Scale goes from 1.25 down to 0.5 of the optimum time
+	double scale = std::max(0.5, 1.25 - 0.15 * stableIterations);
+	if (scoreDropped)
+	{
+		scale *= 1.3;
+	}
+
+	// The next iteration usually takes longer than all the previous ones together,
+	// so don't start it unless there is a fair chance to finish it
+	return getElapsed() >= (long long)(optimumTime * scale * 0.6);
+}
+
+long long TimeManager::getElapsed(void) const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
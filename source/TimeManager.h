@@ -0,0 +1,87 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+
+// What the caller wants the search to respect. Zero means "no limit"
+struct SearchLimits
+{
+	int      depth;
+	uint64_t nodes;
+	int      moveTime;     // Fixed time for this move, in milliseconds
+	int      time[2];      // Time left on each player's clock, in milliseconds
+	int      increment[2]; // Increment per move, in milliseconds
+	int      movesToGo;    // Moves until the next time control, 0 for sudden death
+	bool     infinite;     // Search until stopped from outside
+	bool     ponder;       // Search as infinite until the ponder hit, then to the other limits
+	std::vector<CompactMove> searchMoves; // Root moves to choose from, empty for all of them
+
+	SearchLimits();
+
+	bool usesClock(int color) const { return time[color] > 0; }
+};
+
+// Decides how long the search may run and when it has to stop.
+// The clock is a monotonic one and it is only read every POLL_INTERVAL nodes,
+// so checking the limits from the search costs one compare in most nodes
+class TimeManager
+{
+public:
+	// Nodes between two clock reads. Must be a power of two
+	static const uint64_t POLL_INTERVAL = 1024;
+
+	// Time kept back for the GUI and the operating system, in milliseconds
+	static const int DEFAULT_MOVE_OVERHEAD = 10;
+
+	TimeManager();
+
+	void setMoveOverhead(int milliseconds) { moveOverhead = milliseconds; }
+
+	int getMoveOverhead(void) const { return moveOverhead; }
+
+	// Starts the clock and works out the time budget for the side to move
+	void start(const SearchLimits& limits, int sideToMove);
+
+	// Hard limits, called for every node
+	bool isNodeLimitReached(uint64_t nodes) const
+	{
+		return nodes >= nodeLimit;
+	}
+
+	bool isTimeUp(uint64_t nodes) const
+	{
+		if (!hasDeadline || 0 != (nodes & (POLL_INTERVAL - 1)))
+		{
+			return false;
+		}
+		return getElapsed() >= maximumTime;
+	}
+
+	// Soft limit, called after every completed iteration. Once the best move has
+	// been the same for a few iterations we are happy to stop well before the budget runs out
+	bool shouldStopAfterIteration(int depth, const CompactMove& bestMove, int score);
+
+	// The search is playing against the clock (and not to a fixed depth, nodes or move time)
+	bool isClockControlled(void) const { return clockControlled; }
+
+	long long getElapsed(void) const;
+
+	long long getOptimumTime(void) const { return optimumTime; }
+
+	long long getMaximumTime(void) const { return maximumTime; }
+
+private:
+	std::chrono::steady_clock::time_point startTime;
+
+	int moveOverhead;
+
+	bool hasDeadline;
+	bool clockControlled;
+	long long optimumTime;
+	long long maximumTime;
+	uint64_t nodeLimit;
+
+	// Best move stability
+	CompactMove lastBestMove;
+	int lastScore;
+	int stableIterations;
+};
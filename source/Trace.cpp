@@ -0,0 +1,173 @@
+#include "Trace.h"
+#include <cstdlib>
+#include <mutex>
+
+thread_local Trace::Ring* Trace::local = NULL;
+
+namespace
+{
+	std::mutex& registryMutex(void)
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	// Thread names are the only text that does not come from a literal
+	std::string escape(const std::string& text)
+	{
+		std::string escaped;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			if ('"' == text[i] || '\\' == text[i])
+			{
+				escaped += '\\';
+			}
+			escaped += text[i] < 0x20 && text[i] >= 0 ? ' ' : text[i];
+		}
+		return escaped;
+	}
+
+	void writeToFile(void)
+	{
+		const char* fileName = getenv("CHESS_TRACE_FILE");
+		std::ofstream ofs(NULL != fileName && 0 != *fileName ? fileName : "chess_trace.json");
+		if (ofs)
+		{
+			Trace::write(ofs);
+		}
+	}
+}
+
+Trace::Span::Span(const char* name, const char* argument, int64_t value)
+	: name(name), argument(argument), value(value), start(now())
+{
+}
+
+Trace::Span::~Span()
+{
+	Ring* ring = local;
+	if (NULL == ring)
+	{
+		ring = registerThread();
+	}
+
+	// Only this thread writes the ring, the count publishes the event
+	uint64_t index = ring->recorded.load(std::memory_order_relaxed);
+	Event& event = ring->events[index & (RING_SIZE - 1)];
+	event.name = name;
+	event.argument = argument;
+	event.value = value;
+	event.start = start;
+	event.duration = now() - start;
+	ring->recorded.store(index + 1, std::memory_order_release);
+}
+
+std::vector<Trace::Ring*>& Trace::rings(void)
+{
+	// Never destroyed, nor the rings in it, so threads can still record while the process exits
+	static std::vector<Ring*>* all = new std::vector<Ring*>();
+	return *all;
+}
+
+std::vector<Trace::Ring*>& Trace::freeRings(void)
+{
+	static std::vector<Ring*>* ended = new std::vector<Ring*>();
+	return *ended;
+}
+
+Trace::Ring* Trace::registerThread(void)
+{
+	// Constructed once per thread, on the first event; a thread that records
+	// again after its owner is gone, while it exits, keeps the ring it takes
+	static thread_local RingOwner owner;
+	(void)owner;
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+	Ring* ring = NULL;
+	if (!freeRings().empty())
+	{
+		// The events of the ended thread stay, the ring goes on after them
+		ring = freeRings().back();
+		freeRings().pop_back();
+	}
+	else
+	{
+		ring = new Ring();
+		ring->recorded.store(0, std::memory_order_relaxed);
+		ring->id = int(rings().size()) + 1;
+		ring->threadName = "thread " + std::to_string(ring->id);
+		rings().push_back(ring);
+	}
+	local = ring;
+	return ring;
+}
+
+Trace::RingOwner::~RingOwner()
+{
+	if (NULL == local)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(registryMutex());
+	freeRings().push_back(local);
+	local = NULL;
+}
+
+uint64_t Trace::now(void)
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::setThreadName(const std::string& name)
+{
+	if (!ENABLED)
+	{
+		return;
+	}
+
+	Ring* ring = NULL == local ? registerThread() : local;
+	std::lock_guard<std::mutex> lock(registryMutex());
+	ring->threadName = name;
+}
+
+void Trace::write(std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+	const std::vector<Ring*>& all = rings();
+
+	// Times are in microseconds, with the nanoseconds as decimals
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool first = true;
+	for (size_t i = 0; i < all.size(); i++)
+	{
+		const Ring& ring = *all[i];
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring.id
+			<< ",\"args\":{\"name\":\"" << escape(ring.threadName) << "\"}}";
+		first = false;
+
+		uint64_t recorded = ring.recorded.load(std::memory_order_acquire);
+		for (uint64_t j = recorded > RING_SIZE ? recorded - RING_SIZE : 0; j < recorded; j++)
+		{
+			const Event& event = ring.events[j & (RING_SIZE - 1)];
+			out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.id
+				<< ",\"ts\":" << event.start / 1000 << "." << std::setfill('0') << std::setw(3) << event.start % 1000
+				<< ",\"dur\":" << event.duration / 1000 << "." << std::setw(3) << event.duration % 1000 << std::setfill(' ');
+			if (NULL != event.argument)
+			{
+				out << ",\"args\":{\"" << event.argument << "\":" << event.value << "}";
+			}
+			out << "}";
+		}
+	}
+	out << "\n]}\n";
+}
+
+void Trace::writeAtExit(void)
+{
+	if (ENABLED)
+	{
+		atexit(writeToFile);
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "includes.h"
+#include <stdint.h>
+#include <atomic>
+
+// Timed spans of what every thread is doing, written out as Chrome trace events
+// (chrome://tracing or ui.perfetto.dev) to see where the time of one command or
+// move goes, thread by thread. Only compiled in with CHESS_TRACE defined (cmake
+// -DCHESS_TRACE=ON, make TRACE=1); otherwise CHESS_TRACE_SPAN is nothing.
+// A span is recorded when it ends, into a ring of RING_SIZE events that belongs
+// to its thread: recording takes no lock, and a long run keeps the last events
+// of every thread rather than growing. A thread that ends hands its ring, name
+// and all, to the next thread that starts, so the rings are as many as the
+// threads that ever ran at once. The rings are read when the trace is
+// written, normally at exit; events recorded while writing can come out torn
+class Trace
+{
+public:
+#ifdef CHESS_TRACE
+	static const bool ENABLED = true;
+#else
+	static const bool ENABLED = false;
+#endif
+
+	static const size_t RING_SIZE = 1 << 16;
+
+	// Times the scope it lives in. The name and the argument name must be string
+	// literals, only their address is kept; the argument shows with the event
+	class Span
+	{
+	public:
+		explicit Span(const char* name, const char* argument = NULL, int64_t value = 0);
+		~Span();
+
+	private:
+		const char* name;
+		const char* argument;
+		int64_t     value;
+		uint64_t    start;
+
+		Span(const Span&);
+		Span& operator=(const Span&);
+	};
+
+	// Shown for the calling thread instead of "thread N"
+	static void setThreadName(const std::string& name);
+
+	// Every event still in the rings, as a trace event JSON document
+	static void write(std::ostream& out);
+
+	// Writes the file named by the CHESS_TRACE_FILE environment variable, or
+	// chess_trace.json, when the process exits, in builds with the tracing
+	static void writeAtExit(void);
+
+private:
+	struct Event
+	{
+		const char* name;
+		const char* argument;
+		int64_t     value;
+		uint64_t    start;    // Nanoseconds since the first event of the process
+		uint64_t    duration;
+	};
+
+	struct Ring
+	{
+		Event events[RING_SIZE];
+		std::atomic<uint64_t> recorded; // Ever; the ring holds the last RING_SIZE
+		int id;
+		std::string threadName;
+	};
+
+	// Gives the ring of its thread back when the thread ends
+	struct RingOwner
+	{
+		~RingOwner();
+	};
+
+	static thread_local Ring* local;
+
+	static std::vector<Ring*>& rings(void);
+
+	// The rings of the threads that have ended, to be taken by new threads
+	static std::vector<Ring*>& freeRings(void);
+
+	static Ring* registerThread(void);
+
+	static uint64_t now(void);
+};
+
+#ifdef CHESS_TRACE
+#define CHESS_TRACE_JOIN(a, b) a##b
+#define CHESS_TRACE_NAME(line) CHESS_TRACE_JOIN(traceSpan, line)
+#define CHESS_TRACE_SPAN(...) Trace::Span CHESS_TRACE_NAME(__LINE__)(__VA_ARGS__)
+#else
+#define CHESS_TRACE_SPAN(...) ((void)0)
+#endif
@@ -0,0 +1,138 @@
+#include "TranspositionTable.h"
+
+// Slot data layout:
+//  bits  0-31 move
+//  bits 32-47 score
+//  bits 48-55 depth
+//  bits 56-57 bound
+//  bits 58-63 generation
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+	: count(0), sizeMb(0), generation(0)
+{
+	resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+	if (megabytes < 1)
+	{
+		megabytes = 1;
+	}
+
+	// Keep the number of slots a power of two, so the index is just a mask
+	size_t wanted = megabytes * 1024 * 1024 / sizeof(Slot);
+	size_t slotCount = 1;
+	while (slotCount * 2 <= wanted)
+	{
+		slotCount *= 2;
+	}
+
+	slots.reset(new Slot[slotCount]);
+	count = slotCount;
+	sizeMb = megabytes;
+	clear();
+}
+
+void TranspositionTable::clear(void)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		slots[i].check.store(0, std::memory_order_relaxed);
+		slots[i].data.store(0, std::memory_order_relaxed);
+	}
+	generation = 0;
+}
+
+void TranspositionTable::newSearch(void)
+{
+	generation = (generation + 1) & 0x3F;
+}
+
+uint64_t TranspositionTable::encode(const CompactMove& move, int score, int depth, int bound, uint8_t generation)
+{
+	if (depth < 0)
+	{
+		depth = 0;
+	}
+	else if (depth > 255)
+	{
+		depth = 255;
+	}
+
+	return uint64_t(move.pack()) |
+		(uint64_t(uint16_t(int16_t(score))) << 32) |
+		(uint64_t(depth) << 48) |
+		(uint64_t(bound & 0x3) << 56) |
+		(uint64_t(generation & 0x3F) << 58);
+}
+
+bool TranspositionTable::probe(uint64_t key, Entry& entry) const
+{
+	const Slot& slot = slots[key & (count - 1)];
+	uint64_t data = slot.data.load(std::memory_order_relaxed);
+	uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+	if ((check ^ data) != key || 0 == data)
+	{
+		return false;
+	}
+
+	entry.move = CompactMove::unpack(uint32_t(data));
+	entry.score = int16_t(uint16_t(data >> 32));
+	entry.depth = int((data >> 48) & 0xFF);
+	entry.bound = int((data >> 56) & 0x3);
+	return true;
+}
+
+void TranspositionTable::store(uint64_t key, const CompactMove& move, int score, int depth, int bound)
+{
+	Slot& slot = slots[key & (count - 1)];
+	uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+	uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+
+	if ((oldCheck ^ oldData) == key && 0 != oldData)
+	{
+		int oldDepth = int((oldData >> 48) & 0xFF);
+		uint8_t oldGeneration = uint8_t((oldData >> 58) & 0x3F);
+
+		// Same position: keep a deeper result from this search, unless the new one is exact
+		if (oldGeneration == generation && depth < oldDepth - 2 && BOUND_EXACT != bound)
+		{
+			return;
+		}
+
+		// Do not lose the best move when the new result does not have one
+		CompactMove keep = move;
+		if (keep.isNull())
+		{
+			keep = CompactMove::unpack(uint32_t(oldData));
+		}
+
+		uint64_t data = encode(keep, score, depth, bound, generation);
+		slot.check.store(key ^ data, std::memory_order_relaxed);
+		slot.data.store(data, std::memory_order_relaxed);
+		return;
+	}
+
+	uint64_t data = encode(move, score, depth, bound, generation);
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull(void) const
+{
+	size_t sample = count < 1000 ? count : 1000;
+	int used = 0;
+
+	for (size_t i = 0; i < sample; i++)
+	{
+		uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+		if (0 != data && uint8_t((data >> 58) & 0x3F) == generation)
+		{
+			used++;
+		}
+	}
+
+	return int(used * 1000 / sample);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "includes.h"
+#include "Board.h"
+#include <atomic>
+#include <memory>
+
+// Hash table of already searched positions, shared by all the search threads.
+// Every slot keeps the key XORed with the data, so a slot that is being written
+// by another thread at the same time is simply seen as a miss
+class TranspositionTable
+{
+public:
+	enum Bound
+	{
+		BOUND_NONE  = 0,
+		BOUND_UPPER = 1,
+		BOUND_LOWER = 2,
+		BOUND_EXACT = 3
+	};
+
+	struct Entry
+	{
+		CompactMove move;
+		int score;
+		int depth;
+		int bound;
+	};
+
+	static const size_t DEFAULT_SIZE_MB = 16;
+
+	explicit TranspositionTable(size_t megabytes = DEFAULT_SIZE_MB);
+
+	void resize(size_t megabytes);
+
+	void clear(void);
+
+	// Called once per search, so entries from old searches are replaced first
+	void newSearch(void);
+
+	bool probe(uint64_t key, Entry& entry) const;
+
+	void store(uint64_t key, const CompactMove& move, int score, int depth, int bound);
+
+	// How full the table is, in permill (sampled from the first 1000 slots)
+	int hashfull(void) const;
+
+	size_t getSizeMb(void) const { return sizeMb; }
+
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t count;
+	size_t sizeMb;
+	uint8_t generation;
+
+	static uint64_t encode(const CompactMove& move, int score, int depth, int bound, uint8_t generation);
+};
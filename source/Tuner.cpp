@@ -0,0 +1,313 @@
+#include "Tuner.h"
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	// Scales centipawns for the sigmoid: 1 / (1 + 10^(-k * eval / 400))
+	const double SIGMOID_SCALE = std::log(10.0) / 400.0;
+
+	double sigmoid(double k, double eval)
+	{
+		return 1.0 / (1.0 + std::exp(-k * SIGMOID_SCALE * eval));
+	}
+}
+
+Tuner::Settings::Settings()
+{
+	epochs = 1000;
+	learningRate = 1.0;
+	k = 0.0;
+	reportInterval = 50;
+	outputFile = "weights.txt";
+}
+
+Tuner::Tuner()
+{
+	weights.resize(Evaluation::PARAMETER_COUNT);
+	setWeights(Evaluation());
+	threads = std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+bool Tuner::parseResult(const std::string& text, uint8_t& result)
+{
+	// Draws first, "1/2-1/2" contains the other two
+	if (string::npos != text.find("1/2-1/2") || string::npos != text.find("[0.5]"))
+	{
+		result = 1;
+	}
+	else if (string::npos != text.find("1-0") || string::npos != text.find("[1.0]"))
+	{
+		result = 2;
+	}
+	else if (string::npos != text.find("0-1") || string::npos != text.find("[0.0]"))
+	{
+		result = 0;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+size_t Tuner::load(const std::string& fileName)
+{
+	std::ifstream ifs(fileName);
+	if (!ifs)
+	{
+		throw invalid_argument("Error loading " + fileName + "\n");
+	}
+
+	string line;
+	while (std::getline(ifs, line))
+	{
+		// The first four fields are the position, the rest holds the result
+		std::istringstream stream(line);
+		string fields[4];
+		if (!(stream >> fields[0] >> fields[1] >> fields[2] >> fields[3]))
+		{
+			continue;
+		}
+
+		string rest;
+		std::getline(stream, rest);
+
+		Entry entry;
+		Board board;
+		if (!parseResult(rest, entry.result) ||
+			!board.setFromFen(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]) ||
+			board.isInCheck())
+		{
+			continue;
+		}
+
+		entry.first = uint32_t(features.size());
+		entry.count = 0;
+		int phase = 0;
+
+		for (int square = 0; square < 64; square++)
+		{
+			char piece = board.squares[square];
+			if (Chess::EMPTY_FIELD == piece)
+			{
+				continue;
+			}
+
+			int kind = Evaluation::pieceKind(piece);
+			phase += Evaluation::phaseWeight(kind);
+
+			if (piece < 'a')
+			{
+				features.push_back(uint16_t(kind * 64 + square));
+			}
+			else
+			{
+				features.push_back(uint16_t(kind * 64 + (square ^ 56)) | BLACK_FEATURE);
+			}
+			entry.count++;
+		}
+
+		entry.phase = uint8_t(std::min(phase, int(Evaluation::MAX_PHASE)));
+		entries.push_back(entry);
+	}
+
+	return entries.size();
+}
+
+void Tuner::setWeights(const Evaluation& evaluation)
+{
+	for (int i = 0; i < Evaluation::PARAMETER_COUNT; i++)
+	{
+		weights[i] = evaluation.getParameter(i);
+	}
+}
+
+void Tuner::getWeights(Evaluation& evaluation) const
+{
+	for (int i = 0; i < Evaluation::PARAMETER_COUNT; i++)
+	{
+		evaluation.setParameter(i, int(std::lround(weights[i])));
+	}
+}
+
+void Tuner::fold(float mgTable[], float egTable[]) const
+{
+	for (int index = 0; index < FEATURE_COUNT; index++)
+	{
+		mgTable[index] = float(weights[Evaluation::MG_MATERIAL + index / 64] + weights[Evaluation::MG_TABLES + index]);
+		egTable[index] = float(weights[Evaluation::EG_MATERIAL + index / 64] + weights[Evaluation::EG_TABLES + index]);
+	}
+}
+
+void Tuner::parallel(std::function<void(int thread, size_t begin, size_t end)> work) const
+{
+	std::vector<std::thread> pool;
+	size_t chunk = (entries.size() + threads - 1) / threads;
+
+	for (int i = 0; i < threads; i++)
+	{
+		size_t begin = std::min(entries.size(), i * chunk);
+		size_t end = std::min(entries.size(), begin + chunk);
+		pool.push_back(std::thread(work, i, begin, end));
+	}
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		pool[i].join();
+	}
+}
+
+double Tuner::error(double k) const
+{
+	if (entries.empty())
+	{
+		return 0.0;
+	}
+
+	float mgTable[FEATURE_COUNT];
+	float egTable[FEATURE_COUNT];
+	fold(mgTable, egTable);
+
+	std::vector<double> sums(threads, 0.0);
+	parallel([&](int thread, size_t begin, size_t end)
+	{
+		double sum = 0.0;
+		for (size_t i = begin; i < end; i++)
+		{
+			double difference = entries[i].result * 0.5 - sigmoid(k, evaluate(entries[i], mgTable, egTable));
+			sum += difference * difference;
+		}
+		sums[thread] = sum;
+	});
+
+	double total = 0.0;
+	for (int i = 0; i < threads; i++)
+	{
+		total += sums[i];
+	}
+	return total / entries.size();
+}
+
+double Tuner::fitK(void) const
+{
+	// The error is convex enough in K for a golden section search
+	const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+	double low = 0.0;
+	double high = 4.0;
+
+	while (high - low > 0.001)
+	{
+		double a = high - ratio * (high - low);
+		double b = low + ratio * (high - low);
+		if (error(a) < error(b))
+		{
+			high = b;
+		}
+		else
+		{
+			low = a;
+		}
+	}
+
+	return (low + high) / 2.0;
+}
+
+void Tuner::gradient(double k, std::vector<double>& result) const
+{
+	float mgTable[FEATURE_COUNT];
+	float egTable[FEATURE_COUNT];
+	fold(mgTable, egTable);
+
+	// Every thread sums into its own tables, they are added up afterwards
+	std::vector<std::vector<double> > partial(threads, std::vector<double>(2 * FEATURE_COUNT, 0.0));
+	parallel([&](int thread, size_t begin, size_t end)
+	{
+		double* mg = &partial[thread][0];
+		double* eg = &partial[thread][FEATURE_COUNT];
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const Entry& entry = entries[i];
+			double s = sigmoid(k, evaluate(entry, mgTable, egTable));
+
+			// d(error) / d(eval), then split between the middle game and end game weights
+			double slope = -2.0 * (entry.result * 0.5 - s) * s * (1.0 - s) * k * SIGMOID_SCALE;
+			double mgSlope = slope * entry.phase / Evaluation::MAX_PHASE;
+			double egSlope = slope - mgSlope;
+
+			const uint16_t* feature = &features[entry.first];
+			for (int j = 0; j < entry.count; j++)
+			{
+				double sign = (feature[j] & BLACK_FEATURE) ? -1.0 : 1.0;
+				int index = feature[j] & FEATURE_MASK;
+				mg[index] += sign * mgSlope;
+				eg[index] += sign * egSlope;
+			}
+		}
+	});
+
+	result.assign(Evaluation::PARAMETER_COUNT, 0.0);
+	for (int thread = 0; thread < threads; thread++)
+	{
+		for (int index = 0; index < FEATURE_COUNT; index++)
+		{
+			double mg = partial[thread][index] / entries.size();
+			double eg = partial[thread][FEATURE_COUNT + index] / entries.size();
+
+			result[Evaluation::MG_TABLES + index] += mg;
+			result[Evaluation::EG_TABLES + index] += eg;
+
+			// Both kings are always on the board, their material means nothing
+			if (Evaluation::KING != index / 64)
+			{
+				result[Evaluation::MG_MATERIAL + index / 64] += mg;
+				result[Evaluation::EG_MATERIAL + index / 64] += eg;
+			}
+		}
+	}
+}
+
+void Tuner::run(const Settings& settings, std::ostream& out)
+{
+	double k = settings.k > 0.0 ? settings.k : fitK();
+	out << "Positions: " << entries.size() << ", threads: " << threads << ", K: " << k << "\n";
+	out << "Epoch 0, error " << std::setprecision(8) << error(k) << endl;
+
+	// Adam, on the whole set at every step
+	const double beta1 = 0.9;
+	const double beta2 = 0.999;
+	std::vector<double> gradients;
+	std::vector<double> moment(Evaluation::PARAMETER_COUNT, 0.0);
+	std::vector<double> velocity(Evaluation::PARAMETER_COUNT, 0.0);
+
+	for (int epoch = 1; epoch <= settings.epochs; epoch++)
+	{
+		gradient(k, gradients);
+
+		double correction1 = 1.0 - std::pow(beta1, epoch);
+		double correction2 = 1.0 - std::pow(beta2, epoch);
+
+		for (int i = 0; i < Evaluation::PARAMETER_COUNT; i++)
+		{
+			moment[i] = beta1 * moment[i] + (1.0 - beta1) * gradients[i];
+			velocity[i] = beta2 * velocity[i] + (1.0 - beta2) * gradients[i] * gradients[i];
+			weights[i] -= settings.learningRate * (moment[i] / correction1) / (std::sqrt(velocity[i] / correction2) + 1e-8);
+		}
+
+		if (0 == epoch % settings.reportInterval || epoch == settings.epochs)
+		{
+			out << "Epoch " << epoch << ", error " << std::setprecision(8) << error(k) << endl;
+
+			if (!settings.outputFile.empty())
+			{
+				Evaluation evaluation;
+				getWeights(evaluation);
+				if (!evaluation.saveWeights(settings.outputFile))
+				{
+					out << "Error saving " << settings.outputFile << endl;
+				}
+			}
+		}
+	}
+}
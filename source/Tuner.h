@@ -0,0 +1,96 @@
+#pragma once
+#include "includes.h"
+#include "Evaluation.h"
+#include <functional>
+
+// Texel tuning: fits the evaluation weights to game results by minimizing
+// the squared error between the result and sigmoid(K * eval) over a set of
+// labeled positions. The evaluation is linear in its weights, so a position
+// is kept as just its phase and a short list of (piece, square) features;
+// a few million positions fit in a few hundred megabytes
+class Tuner
+{
+public:
+	struct Settings
+	{
+		int         epochs;
+		double      learningRate;   // Adam step, in centipawns
+		double      k;              // Sigmoid scale, 0 to fit it first
+		int         reportInterval; // Epochs between progress lines and saves
+		std::string outputFile;     // Empty to skip saving
+
+		Settings();
+	};
+
+	Tuner();
+
+	void setThreads(int count) { threads = count > 0 ? count : 1; }
+
+	// One position per line: a FEN followed by the result, as 1-0, 0-1, 1/2-1/2
+	// (quoted or not) or [1.0], [0.5], [0.0]. Positions in check and lines that
+	// can't be read are skipped. Throws invalid_argument if the file can't be opened
+	size_t load(const std::string& fileName);
+
+	size_t size(void) const { return entries.size(); }
+
+	void setWeights(const Evaluation& evaluation);
+
+	void getWeights(Evaluation& evaluation) const;
+
+	// Mean squared error of the current weights with the given K
+	double error(double k) const;
+
+	// K that minimizes the error of the current weights
+	double fitK(void) const;
+
+	void run(const Settings& settings, std::ostream& out);
+
+private:
+	// A feature is kind * 64 + square, squares seen from the piece owner's
+	// side, with BLACK_FEATURE set for black pieces
+	static const uint16_t BLACK_FEATURE = 0x8000;
+	static const uint16_t FEATURE_MASK = 0x01FF;
+	static const int FEATURE_COUNT = Evaluation::PIECE_KINDS * 64;
+
+	struct Entry
+	{
+		uint32_t first; // Index of the first feature
+		uint8_t  count;
+		uint8_t  phase;
+		uint8_t  result; // In half points for white: 0, 1 or 2
+	};
+
+	std::vector<Entry>    entries;
+	std::vector<uint16_t> features;
+	std::vector<double>   weights;
+
+	int threads;
+
+	// Material folded into the tables, like Evaluation::refresh()
+	void fold(float mgTable[], float egTable[]) const;
+
+	// White's point of view. A plain loop over flat arrays, so it can be vectorized
+	float evaluate(const Entry& entry, const float mgTable[], const float egTable[]) const
+	{
+		const uint16_t* feature = &features[entry.first];
+		float mg = 0.0f;
+		float eg = 0.0f;
+
+		for (int i = 0; i < entry.count; i++)
+		{
+			float sign = 1.0f - 2.0f * (feature[i] >> 15);
+			int index = feature[i] & FEATURE_MASK;
+			mg += sign * mgTable[index];
+			eg += sign * egTable[index];
+		}
+
+		return (mg * entry.phase + eg * (Evaluation::MAX_PHASE - entry.phase)) / Evaluation::MAX_PHASE;
+	}
+
+	void gradient(double k, std::vector<double>& result) const;
+
+	// Splits the positions into one range per thread
+	void parallel(std::function<void(int thread, size_t begin, size_t end)> work) const;
+
+	static bool parseResult(const std::string& text, uint8_t& result);
+};
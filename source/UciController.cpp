@@ -0,0 +1,345 @@
+#include "UciController.h"
+#include "Bench.h"
+
+UciController::UciController()
+	: random(std::random_device()())
+{
+	board.setStartPosition();
+	ownBook = false;
+}
+
+void UciController::send(const std::string& line)
+{
+	// Info lines come from the search thread, everything else from this one
+	std::lock_guard<std::mutex> lock(outputMutex);
+	cout << line << endl;
+}
+
+void UciController::loop(void)
+{
+	string line;
+
+	while (getline(cin, line))
+	{
+		std::istringstream stream(line);
+		string command;
+		stream >> command;
+
+		if ("uci" == command)
+		{
+			handleUci();
+		}
+		else if ("isready" == command)
+		{
+			send("readyok");
+		}
+		else if ("setoption" == command)
+		{
+			handleSetOption(stream);
+		}
+		else if ("ucinewgame" == command)
+		{
+			engine.stop();
+			engine.newGame();
+		}
+		else if ("position" == command)
+		{
+			engine.stop();
+			engine.wait();
+			handlePosition(stream);
+		}
+		else if ("go" == command)
+		{
+			handleGo(stream);
+		}
+		else if ("stop" == command)
+		{
+			engine.stop();
+		}
+		else if ("ponderhit" == command)
+		{
+			engine.ponderHit();
+		}
+		else if ("bench" == command)
+		{
+			// Not part of UCI, but match tools and scripts use it to check the build
+			int depth = Bench::DEFAULT_DEPTH;
+			stream >> depth;
+
+			engine.stop();
+			engine.wait();
+
+			std::lock_guard<std::mutex> lock(outputMutex);
+			Bench::run(depth > 0 ? depth : Bench::DEFAULT_DEPTH, cout);
+		}
+		else if ("quit" == command)
+		{
+			break;
+		}
+		else if (!command.empty())
+		{
+			send("info string Unknown command: " + command);
+		}
+	}
+
+	engine.stop();
+	engine.wait();
+}
+
+void UciController::handleUci(void)
+{
+	send("id name Chess console");
+	send("id author dimitrov-k");
+	send("option name Hash type spin default " + std::to_string(TranspositionTable::DEFAULT_SIZE_MB) +
+		" min 1 max " + std::to_string(Engine::MAX_HASH_MB));
+	send("option name Threads type spin default 1 min 1 max " + std::to_string(Engine::MAX_THREADS));
+	send("option name Move Overhead type spin default " + std::to_string(TimeManager::DEFAULT_MOVE_OVERHEAD) +
+		" min 0 max 5000");
+	send("option name MultiPV type spin default 1 min 1 max " + std::to_string(Search::MAX_MULTI_PV));
+	send("option name OwnBook type check default false");
+	send("option name Book File type string default <empty>");
+	send("option name TablebasePath type string default <empty>");
+	send("uciok");
+}
+
+void UciController::handleSetOption(std::istringstream& stream)
+{
+	// setoption name <name, may have spaces> value <value>
+	string token, name, value;
+	stream >> token;
+
+	while (stream >> token && "value" != token)
+	{
+		name += (name.empty() ? "" : " ") + token;
+	}
+
+	// File names may have spaces too
+	std::getline(stream >> std::ws, value);
+
+	// Options can't change under a running search
+	engine.stop();
+	engine.wait();
+
+	try
+	{
+		if ("Hash" == name)
+		{
+			engine.setHashSize(std::stoul(value));
+		}
+		else if ("Threads" == name)
+		{
+			engine.setThreads(std::stoi(value));
+		}
+		else if ("Move Overhead" == name)
+		{
+			engine.setMoveOverhead(std::stoi(value));
+		}
+		else if ("MultiPV" == name)
+		{
+			engine.setMultiPv(std::stoi(value));
+		}
+		else if ("OwnBook" == name)
+		{
+			ownBook = "true" == value;
+		}
+		else if ("Book File" == name)
+		{
+			book.close();
+			if (!value.empty() && "<empty>" != value && !book.open(value))
+			{
+				send("info string Can't open book " + value);
+			}
+		}
+		else if ("TablebasePath" == name)
+		{
+			int loaded = engine.setTablebasePath("<empty>" == value ? "" : value);
+			send("info string Found " + std::to_string(loaded) + " tablebases");
+		}
+		else
+		{
+			send("info string Unknown option: " + name);
+		}
+	}
+	catch (std::exception&)
+	{
+		send("info string Invalid value for " + name + ": " + value);
+	}
+}
+
+void UciController::handlePosition(std::istringstream& stream)
+{
+	// position startpos [moves ...] | position fen <fen> [moves ...]
+	string token;
+	stream >> token;
+
+	Board position;
+	if ("startpos" == token)
+	{
+		position.setStartPosition();
+		stream >> token;
+	}
+	else if ("fen" == token)
+	{
+		string fen;
+		while (stream >> token && "moves" != token)
+		{
+			fen += (fen.empty() ? "" : " ") + token;
+		}
+
+		if (!position.setFromFen(fen))
+		{
+			send("info string Invalid FEN: " + fen);
+			return;
+		}
+	}
+	else
+	{
+		send("info string Invalid position command");
+		return;
+	}
+
+	std::vector<uint64_t> keys;
+	if ("moves" == token)
+	{
+		while (stream >> token)
+		{
+			CompactMove move = position.parseUci(token);
+			if (move.isNull())
+			{
+				send("info string Illegal move: " + token);
+				break;
+			}
+
+			keys.push_back(position.hash);
+			position.makeMove(move);
+		}
+	}
+
+	board = position;
+	history.swap(keys);
+}
+
+void UciController::handleGo(std::istringstream& stream)
+{
+	SearchLimits limits;
+	std::vector<string> tokens;
+	string token;
+	while (stream >> token)
+	{
+		tokens.push_back(token);
+	}
+
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		if ("infinite" == tokens[i])
+		{
+			limits.infinite = true;
+			continue;
+		}
+		if ("ponder" == tokens[i])
+		{
+			limits.ponder = true;
+			continue;
+		}
+		if ("searchmoves" == tokens[i])
+		{
+			// The moves run until the next token that is not one
+			while (i + 1 < tokens.size())
+			{
+				CompactMove move = board.parseUci(tokens[i + 1]);
+				if (move.isNull())
+				{
+					break;
+				}
+				limits.searchMoves.push_back(move);
+				i++;
+			}
+			continue;
+		}
+
+		// Anything else takes a number. Without one the token is left out,
+		// an unknown one is skipped with its number
+		long long value = 0;
+		std::istringstream number(i + 1 < tokens.size() ? tokens[i + 1] : string());
+		if (!(number >> value))
+		{
+			continue;
+		}
+		token = tokens[i++];
+
+		if ("wtime" == token)          limits.time[Chess::WHITE_PLAYER] = int(std::max(value, 1LL));
+		else if ("btime" == token)     limits.time[Chess::BLACK_PLAYER] = int(std::max(value, 1LL));
+		else if ("winc" == token)      limits.increment[Chess::WHITE_PLAYER] = int(value);
+		else if ("binc" == token)      limits.increment[Chess::BLACK_PLAYER] = int(value);
+		else if ("movestogo" == token) limits.movesToGo = int(value);
+		else if ("depth" == token)     limits.depth = int(value);
+		else if ("nodes" == token)     limits.nodes = uint64_t(value);
+		else if ("movetime" == token)  limits.moveTime = int(value);
+		else if ("mate" == token)      limits.depth = int(std::max(value, 1LL) * 2 - 1); // A mate in N is N * 2 - 1 plies deep
+	}
+
+	// One search at a time: a go during a search ends the one running
+	engine.stop();
+	engine.wait();
+
+	// A book move is sent right away, unless the GUI wants an analysis or ponders
+	if (ownBook && !limits.infinite && !limits.ponder)
+	{
+		CompactMove move = book.pick(board, random());
+		if (!move.isNull())
+		{
+			send("bestmove " + Board::toUci(move));
+			return;
+		}
+	}
+
+	engine.start(board, limits, history,
+		[this](const Search::Result& result)
+		{
+			for (size_t i = 0; i < result.lines.size(); i++)
+			{
+				send(formatInfo(result, i));
+			}
+		},
+		[this](const Search::Result& result)
+		{
+			string line = "bestmove " + (result.bestMove.isNull() ? string("0000") : Board::toUci(result.bestMove));
+			if (!result.ponderMove.isNull())
+			{
+				line += " ponder " + Board::toUci(result.ponderMove);
+			}
+			send(line);
+		});
+}
+
+std::string UciController::formatScore(int score)
+{
+	if (Search::isMateScore(score))
+	{
+		// UCI wants moves, not plies
+		int moves = score > 0 ? (Search::MATE_SCORE - score + 1) / 2 : -(Search::MATE_SCORE + score) / 2;
+		return "mate " + std::to_string(moves);
+	}
+	return "cp " + std::to_string(score);
+}
+
+std::string UciController::formatInfo(const Search::Result& result, size_t index)
+{
+	long long elapsed = result.elapsed > 0 ? result.elapsed : 1;
+	const Search::Line& pv = result.lines[index];
+
+	string line = "info depth " + std::to_string(result.depth) +
+		(result.lines.size() > 1 ? " multipv " + std::to_string(index + 1) : string()) +
+		" score " + formatScore(pv.score) +
+		" nodes " + std::to_string(result.nodes) +
+		" nps " + std::to_string(result.nodes * 1000 / elapsed) +
+		" time " + std::to_string(result.elapsed) +
+		" hashfull " + std::to_string(engine.getTable().hashfull()) +
+		" pv";
+
+	for (size_t i = 0; i < pv.pv.size(); i++)
+	{
+		line += " " + Board::toUci(pv.pv[i]);
+	}
+	return line;
+}
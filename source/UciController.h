@@ -0,0 +1,43 @@
+#pragma once
+#include "includes.h"
+#include "Engine.h"
+#include "OpeningBook.h"
+#include <sstream>
+#include <random>
+
+// Speaks the UCI protocol on stdin/stdout, so the engine can be driven by
+// chess GUIs and match tools instead of the interactive menu
+class UciController
+{
+public:
+	UciController();
+
+	// Reads commands until "quit" or the end of the input
+	void loop(void);
+
+private:
+	Engine engine;
+	Board board;
+
+	// Hash keys of the positions before the current one, for repetitions
+	std::vector<uint64_t> history;
+
+	// Book moves are played without searching when OwnBook is on
+	OpeningBook book;
+	bool ownBook;
+	std::mt19937 random;
+
+	std::mutex outputMutex;
+
+	void send(const std::string& line);
+
+	void handleUci(void);
+	void handleSetOption(std::istringstream& stream);
+	void handlePosition(std::istringstream& stream);
+	void handleGo(std::istringstream& stream);
+
+	// One info line per multi-PV line
+	std::string formatInfo(const Search::Result& result, size_t index);
+
+	static std::string formatScore(int score);
+};
@@ -1,6 +1,5 @@
 #include "includes.h"
 #include "chess.h"
-#include "user_interface.h"
 
 // Chess class
 int Chess::getPieceColor(char piece)
@@ -80,6 +79,45 @@ std::string Chess::describePiece(char piece)
 	return description;
 }
 
+std::string Chess::describeTerminalState(TerminalState state)
+{
+	switch (state)
+	{
+	case CHECKMATE:             return "checkmate";
+	case STALEMATE:             return "stalemate";
+	case FIFTY_MOVE_RULE:       return "fifty move rule";
+	case THREEFOLD_REPETITION:  return "threefold repetition";
+	case INSUFFICIENT_MATERIAL: return "insufficient material";
+	default:                    return "game in progress";
+	}
+}
+
+const char* Chess::terminalStateName(TerminalState state)
+{
+	switch (state)
+	{
+	case CHECKMATE:             return "checkmate";
+	case STALEMATE:             return "stalemate";
+	case FIFTY_MOVE_RULE:       return "fifty";
+	case THREEFOLD_REPETITION:  return "repetition";
+	case INSUFFICIENT_MATERIAL: return "material";
+	default:                    return "ongoing";
+	}
+}
+
+bool Chess::parseTerminalState(const std::string& name, TerminalState& state)
+{
+	for (int i = ONGOING; i <= INSUFFICIENT_MATERIAL; i++)
+	{
+		if (name == terminalStateName(TerminalState(i)))
+		{
+			state = TerminalState(i);
+			return true;
+		}
+	}
+	return false;
+}
+
 
 // Game class
 
@@ -1,6 +1,9 @@
 #pragma once
 #include "includes.h"
 
+// The content of a square with no piece on it, the same as Chess::EMPTY_FIELD
+#define EMPTY_SQUARE 0x20
+
 class Chess
 {
 public:
@@ -44,6 +47,25 @@ public:
 		KING_SIDE = 3
 	};
 
+	// Why a game is over, or ONGOING if it is not
+	enum TerminalState
+	{
+		ONGOING = 0,
+		CHECKMATE,
+		STALEMATE,
+		FIFTY_MOVE_RULE,
+		THREEFOLD_REPETITION,
+		INSUFFICIENT_MATERIAL
+	};
+
+	static std::string describeTerminalState(TerminalState state);
+
+	// One word, for protocols and files: ongoing, checkmate, stalemate, fifty, repetition, material
+	static const char* terminalStateName(TerminalState state);
+
+	// Back from the word. False when it is not one of them
+	static bool parseTerminalState(const std::string& name, TerminalState& state);
+
 	enum Direction
 	{
 		HORIZONTAL = 0,
@@ -0,0 +1,333 @@
+#include "game.h"
+#include "Rules.h"
+#include "Counters.h"
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+// Rules microbenchmarks: chess_bench test/*.dat
+namespace
+{
+	// Every allocation of the process goes through the operator new below, or
+	// through the tracker's in builds with it, so a benchmark can tell how many
+	// its operations made
+	uint64_t allocations = 0;
+
+	uint64_t countAllocations(void)
+	{
+		return AllocationTracker::ENABLED ? AllocationTracker::totals().allocations : allocations;
+	}
+
+	// Results go here so the compiler can't drop the calls
+	volatile int sink = 0;
+
+	// A position reached in one of the saved games, with the moves to try on it
+	struct Sample
+	{
+		Game game;
+		std::vector<Move> candidates; // Pseudo-legal on the engine board, so some leave the king in check
+		std::vector<Move> legal;      // The ones the rules accept, castling, en passant and promotion filled in
+		std::string record;           // The move that led here, as saved; empty for the start
+
+		// Game can only be copied on construction
+		Sample(const Game& game, const std::string& record) : game(game), record(record)
+		{
+		}
+	};
+
+	struct Benchmark
+	{
+		const char* name;
+		std::function<uint64_t(Sample&)> run; // Returns the operations done on the sample
+	};
+
+	void printUsage(void)
+	{
+		cout << "Usage: chess_bench [options] GAME...\n"
+			<< "  GAME                 A saved game (.dat); every position reached in it is measured\n"
+			<< "  --time MS            Least time spent on each benchmark (default 300)\n"
+			<< "  --filter TEXT        Only run the benchmarks with TEXT in their name\n";
+	}
+
+	Move makeMove(int fromRow, int fromColumn, int toRow, int toColumn)
+	{
+		Chess::Position from = { fromRow, fromColumn };
+		Chess::Position to = { toRow, toColumn };
+		Move move;
+		move.setPresent(from);
+		move.setFuture(to);
+		return move;
+	}
+
+	void addSample(const Game& game, const std::string& record, std::vector<Sample>& samples)
+	{
+		samples.push_back(Sample(game, record));
+		Sample& sample = samples.back();
+
+		Board::MoveList list;
+		game.getPosition().generateMoves(list);
+		for (int i = 0; i < list.count; i++)
+		{
+			const CompactMove& move = list.moves[i];
+
+			// Promotions come once per piece from the engine, the rules ask for the piece later
+			if ((move.flags & CompactMove::FLAG_PROMOTION) && Chess::PIECE_TYPE_QUEEN != move.promotion)
+			{
+				continue;
+			}
+			sample.candidates.push_back(makeMove(Board::rowOf(move.from), Board::columnOf(move.from), Board::rowOf(move.to), Board::columnOf(move.to)));
+
+			Move checked = makeMove(Board::rowOf(move.from), Board::columnOf(move.from), Board::rowOf(move.to), Board::columnOf(move.to));
+			if (Rules::VALID == Rules(sample.game).check(checked))
+			{
+				if (checked.getPromotion()->applied)
+				{
+					checked.getPromotion()->before = sample.game.getPieceAtPosition(checked.getPresent());
+					checked.getPromotion()->after = Chess::WHITE_PLAYER == sample.game.getCurrentTurn() ? Chess::PIECE_TYPE_QUEEN : Chess::PIECE_TYPE_QUEEN_LOW;
+				}
+				sample.legal.push_back(checked);
+			}
+		}
+	}
+
+	// Every position of the game, the start included
+	void loadGame(const std::string& fileName, std::vector<Sample>& samples)
+	{
+		std::ifstream ifs(fileName);
+		if (!ifs)
+		{
+			throw invalid_argument("Can't open " + fileName + "\n");
+		}
+
+		std::deque<Game::Round> rounds;
+		Game::loadRounds(ifs, rounds);
+
+		Game game;
+		addSample(game, string(), samples);
+		for (size_t i = 0; i < rounds.size(); i++)
+		{
+			const string* moves[2] = { &rounds[i].whiteMove, &rounds[i].blackMove };
+			for (int j = 0; j < 2 && !moves[j]->empty(); j++)
+			{
+				string error;
+				if (!Rules::playRecord(game, *moves[j], error))
+				{
+					// The positions up to there are still good
+					cout << fileName << ": " << error << "\n";
+					return;
+				}
+				addSample(game, *moves[j], samples);
+			}
+		}
+	}
+
+	std::vector<Benchmark> makeBenchmarks(void)
+	{
+		std::vector<Benchmark> benchmarks;
+
+		benchmarks.push_back({ "Game::underAttack", [](Sample& sample)
+		{
+			// Every square, as seen by the side to move
+			int color = sample.game.getCurrentTurn();
+			for (int row = 0; row < 8; row++)
+			{
+				for (int column = 0; column < 8; column++)
+				{
+					Chess::Position square = { row, column };
+					sink += sample.game.underAttack(square, color).numAttackers;
+				}
+			}
+			return uint64_t(64);
+		} });
+
+		benchmarks.push_back({ "Game::isKingInCheck", [](Sample& sample)
+		{
+			sink += sample.game.isKingInCheck(Chess::WHITE_PLAYER) + sample.game.isKingInCheck(Chess::BLACK_PLAYER);
+			return uint64_t(2);
+		} });
+
+		benchmarks.push_back({ "Game::isCheckMate", [](Sample& sample)
+		{
+			sink += sample.game.isCheckMate();
+			return uint64_t(1);
+		} });
+
+		benchmarks.push_back({ "Game::findKing", [](Sample& sample)
+		{
+			sink += sample.game.findKing(Chess::WHITE_PLAYER).row + sample.game.findKing(Chess::BLACK_PLAYER).row;
+			return uint64_t(2);
+		} });
+
+		// GameController::isMoveValid is these rules plus printing the reason
+		benchmarks.push_back({ "Rules::check (isMoveValid)", [](Sample& sample)
+		{
+			Rules rules(sample.game);
+			for (size_t i = 0; i < sample.candidates.size(); i++)
+			{
+				sink += rules.check(sample.candidates[i]);
+			}
+			return uint64_t(sample.candidates.size());
+		} });
+
+		benchmarks.push_back({ "Game::movePiece + undoLastMove", [](Sample& sample)
+		{
+			for (size_t i = 0; i < sample.legal.size(); i++)
+			{
+				sample.game.movePiece(&sample.legal[i]);
+				sample.game.undoLastMove();
+			}
+			return uint64_t(sample.legal.size());
+		} });
+
+		benchmarks.push_back({ "Game::parseMove", [](Sample& sample)
+		{
+			if (sample.record.empty())
+			{
+				return uint64_t(0);
+			}
+
+			Chess::Position from;
+			Chess::Position to;
+			char promoted;
+			sample.game.parseMove(sample.record, &from, &to, &promoted);
+			sink += from.row + to.column + promoted;
+			return uint64_t(1);
+		} });
+
+		// logMove is gone; the record text is now made from the compact move when asked for
+		benchmarks.push_back({ "Game::getRecord (logMove)", [](Sample& sample)
+		{
+			size_t plies = sample.game.getPlyCount();
+			for (size_t i = 0; i < plies; i++)
+			{
+				sink += sample.game.getRecord(i)[0];
+			}
+			return uint64_t(plies);
+		} });
+
+		return benchmarks;
+	}
+}
+
+#ifndef CHESS_ALLOC_TRACKING
+void* operator new(std::size_t size)
+{
+	allocations++;
+	void* memory = malloc(0 == size ? 1 : size);
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	long long minimumTime = 300;
+	std::string filter;
+	std::vector<std::string> files;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if (0 != option.compare(0, 2, "--"))
+			{
+				files.push_back(option);
+			}
+			else if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--time" == option)   minimumTime = std::max(1LL, std::stoll(argv[++i]));
+			else if ("--filter" == option) filter = argv[++i];
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+
+		if (files.empty())
+		{
+			throw invalid_argument("No games given\n");
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	Counters::dumpAtExit();
+	AllocationTracker::reportAtExit();
+
+	std::vector<Sample> samples;
+	try
+	{
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			loadGame(files[i], samples);
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		return 1;
+	}
+	cout << "Positions: " << samples.size() << " from " << files.size() << " games\n";
+
+	std::vector<Benchmark> benchmarks = makeBenchmarks();
+	for (size_t b = 0; b < benchmarks.size(); b++)
+	{
+		if (!filter.empty() && string::npos == string(benchmarks[b].name).find(filter))
+		{
+			continue;
+		}
+
+		// Once over everything first, so containers have grown and caches are warm
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			benchmarks[b].run(samples[i]);
+		}
+
+		uint64_t operations = 0;
+		uint64_t allocationsBefore = countAllocations();
+		auto start = std::chrono::steady_clock::now();
+		long long elapsed = 0;
+		while (elapsed < minimumTime * 1000000LL)
+		{
+			for (size_t i = 0; i < samples.size(); i++)
+			{
+				operations += benchmarks[b].run(samples[i]);
+			}
+			elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		uint64_t allocated = countAllocations() - allocationsBefore;
+
+		double perOperation = operations > 0 ? double(elapsed) / operations : 0.0;
+		double allocationsPerOperation = operations > 0 ? double(allocated) / operations : 0.0;
+		cout << std::left << std::setw(34) << benchmarks[b].name << std::right
+			<< std::fixed << std::setprecision(1) << std::setw(10) << perOperation << " ns/op"
+			<< std::setprecision(2) << std::setw(10) << allocationsPerOperation << " allocs/op"
+			<< "   (" << operations << " ops)\n";
+	}
+
+	return 0;
+}
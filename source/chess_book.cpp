@@ -0,0 +1,153 @@
+#include "BookBuilder.h"
+#include <sstream>
+
+// Opening book tool:
+//   chess_book build book.bin games/*.dat [--plies N]
+//   chess_book probe book.bin [E2-E4 E7-E5 ...]
+//   chess_book verify
+namespace
+{
+	struct KnownKey
+	{
+		const char* fen;
+		uint64_t    key;
+	};
+
+	// The example positions of the Polyglot book format, with their keys
+	const KnownKey POLYGLOT_KEYS[] =
+	{
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",           0x463B96181691FC9CULL },
+		{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",        0x823C9B50FD114196ULL },
+		{ "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",      0x0756B94461C50FB0ULL },
+		{ "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2",        0x662FAFB965DB29D4ULL },
+		{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",      0x22A48B5A8E47FF78ULL },
+		{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3",         0x652A607CA3F242C1ULL },
+		{ "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4",          0x00FDD303C946BDD9ULL },
+		{ "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3",      0x3C8123EA7B067637ULL },
+		{ "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4",       0x5C3F9B829B279560ULL }
+	};
+
+	void printUsage(void)
+	{
+		cout << "Usage: chess_book build BOOK FILE.dat... [--plies N]\n"
+			<< "       chess_book probe BOOK [MOVES...]\n"
+			<< "       chess_book verify\n"
+			<< "  build   Collects the first N plies (default " << BookBuilder::DEFAULT_MAX_PLIES << ") of the saved games\n"
+			<< "  probe   Lists the book moves after the given moves (E2-E4 or e2e4) from the start position\n"
+			<< "  verify  Checks the position keys against the ones published with the Polyglot format\n";
+	}
+
+	int verify(void)
+	{
+		int failed = 0;
+		for (size_t i = 0; i < sizeof(POLYGLOT_KEYS) / sizeof(POLYGLOT_KEYS[0]); i++)
+		{
+			Board board;
+			if (!board.setFromFen(POLYGLOT_KEYS[i].fen) || POLYGLOT_KEYS[i].key != board.hash)
+			{
+				cout << "Wrong key " << std::hex << board.hash << " instead of " << POLYGLOT_KEYS[i].key << std::dec
+					<< " for " << POLYGLOT_KEYS[i].fen << "\n";
+				failed++;
+			}
+		}
+
+		cout << (0 == failed ? "All the Polyglot keys match\n" : "The keys do not match the Polyglot ones, other books will not be found\n");
+		return 0 == failed ? 0 : 1;
+	}
+
+	int build(int argc, char* argv[])
+	{
+		int plies = BookBuilder::DEFAULT_MAX_PLIES;
+		std::vector<std::string> files;
+
+		for (int i = 3; i < argc; i++)
+		{
+			if (0 == strcmp(argv[i], "--plies") && i + 1 < argc)
+			{
+				plies = atoi(argv[++i]);
+			}
+			else
+			{
+				files.push_back(argv[i]);
+			}
+		}
+
+		BookBuilder builder(plies);
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			if (!builder.addGame(files[i]))
+			{
+				cout << "Error loading " << files[i] << "\n";
+			}
+		}
+
+		size_t entries = builder.save(argv[2]);
+		cout << "Saved " << entries << " entries from " << builder.getGames() << " games in " << argv[2] << "\n";
+		return entries > 0 ? 0 : 1;
+	}
+
+	int probe(int argc, char* argv[])
+	{
+		OpeningBook book;
+		if (!book.open(argv[2]))
+		{
+			cout << "Error loading " << argv[2] << "\n";
+			return 1;
+		}
+
+		Board board;
+		board.setStartPosition();
+		for (int i = 3; i < argc; i++)
+		{
+			CompactMove move = board.parseRecord(argv[i]);
+			if (move.isNull())
+			{
+				move = board.parseUci(argv[i]);
+			}
+			if (move.isNull())
+			{
+				cout << "Illegal move " << argv[i] << "\n";
+				return 1;
+			}
+			board.makeMove(move);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<OpeningBook::Entry> entries = book.probe(board);
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		uint32_t total = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			total += entries[i].weight;
+		}
+
+		cout << board.toFen() << "\n";
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			cout << std::left << std::setw(8) << board.toRecord(entries[i].move) << std::right << std::setw(6) << entries[i].weight
+				<< std::setw(7) << std::fixed << std::setprecision(1) << 100.0 * entries[i].weight / total << "%\n";
+		}
+		cout << entries.size() << " moves out of " << book.size() << " entries, found in " << elapsed << " us\n";
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 3 && 0 == strcmp(argv[1], "build"))
+	{
+		return build(argc, argv);
+	}
+	if (argc >= 3 && 0 == strcmp(argv[1], "probe"))
+	{
+		return probe(argc, argv);
+	}
+	if (argc >= 2 && 0 == strcmp(argv[1], "verify"))
+	{
+		return verify();
+	}
+
+	printUsage();
+	return 1;
+}
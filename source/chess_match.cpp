@@ -0,0 +1,108 @@
+#include "Match.h"
+
+// Self-play tool: chess_match --games 2000 --tc 10+0.1 --engine1 name=new,hash=32 --engine2 name=base --sprt 0 5
+namespace
+{
+	void printUsage(void)
+	{
+		cout << "Usage: chess_match [options]\n"
+			<< "  --games N            Number of games (default 100)\n"
+			<< "  --concurrency N      Games played at the same time (default: all cores)\n"
+			<< "  --tc S+I             Seconds per game plus increment per move (default 10+0.1), 0 for no clock\n"
+			<< "  --overhead MS        Move overhead in milliseconds\n"
+			<< "  --maxplies N         Adjudicate longer games as draws (default 400)\n"
+			<< "  --openings FILE      One opening per line, in E2-E4 or e2e4 notation\n"
+			<< "  --out PREFIX         Save games as PREFIX0001.dat, ... (default match_), \"\" to skip\n"
+			<< "  --engine1 K=V,...    name, hash, depth, nodes, weights, book\n"
+			<< "  --engine2 K=V,...\n"
+			<< "  --sprt ELO0 ELO1 [ALPHA BETA]\n";
+	}
+
+	void parseTimeControl(const std::string& text, Match::Settings& settings)
+	{
+		size_t plus = text.find('+');
+		settings.baseTime = int(std::stod(text.substr(0, plus)) * 1000);
+		settings.increment = string::npos == plus ? 0 : int(std::stod(text.substr(plus + 1)) * 1000);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Match::Settings settings;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if (!hasValue)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--games" == option)       settings.games = std::stoi(argv[++i]);
+			else if ("--concurrency" == option) settings.concurrency = std::max(1, std::stoi(argv[++i]));
+			else if ("--tc" == option)          parseTimeControl(argv[++i], settings);
+			else if ("--overhead" == option)    settings.moveOverhead = std::stoi(argv[++i]);
+			else if ("--maxplies" == option)    settings.maxPlies = std::stoi(argv[++i]);
+			else if ("--openings" == option)    settings.openingsFile = argv[++i];
+			else if ("--out" == option)         settings.outputPrefix = argv[++i];
+			else if ("--engine1" == option)     settings.engines[0].parse(argv[++i]);
+			else if ("--engine2" == option)     settings.engines[1].parse(argv[++i]);
+			else if ("--sprt" == option)
+			{
+				if (i + 2 >= argc)
+				{
+					throw invalid_argument("--sprt needs at least ELO0 and ELO1\n");
+				}
+				settings.sprt = true;
+				settings.elo0 = std::stod(argv[++i]);
+				settings.elo1 = std::stod(argv[++i]);
+				if (i + 2 < argc && '-' != argv[i + 1][0])
+				{
+					settings.alpha = std::stod(argv[++i]);
+					settings.beta = std::stod(argv[++i]);
+				}
+			}
+			else
+			{
+				throw invalid_argument("Unknown option " + option + "\n");
+			}
+		}
+
+		// Without a clock some other limit has to end the moves
+		if (0 == settings.baseTime)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				if (0 == settings.engines[i].depth && 0 == settings.engines[i].nodes)
+				{
+					throw invalid_argument("--tc 0 needs a depth or nodes limit for " + settings.engines[i].name + "\n");
+				}
+			}
+		}
+
+		Match match(settings);
+		match.run(cout);
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}
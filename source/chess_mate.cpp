@@ -0,0 +1,221 @@
+#include "MateSolver.h"
+#include "game.h"
+#include <sstream>
+
+// Mate finder: chess_mate --depth 5 "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4"
+namespace
+{
+	struct Position
+	{
+		std::string fen;
+		int expected; // Mate length given by an EPD "dm" operation, 0 when there is none
+	};
+
+	void printUsage(void)
+	{
+		cout << "Usage: chess_mate [options] POSITION...\n"
+			<< "  POSITION             A FEN, a file with one FEN or EPD per line, or a saved game (.dat, its last position)\n"
+			<< "                       EPD lines with \"dm N\" are checked to be a mate in exactly N\n"
+			<< "  --depth N            Longest mate looked for, in moves (default 5)\n"
+			<< "  --nodes N            Give up on a position after N nodes (default: no limit)\n"
+			<< "  --hash MB            Transposition table size (default " << MateSolver::DEFAULT_HASH_MB << ")\n";
+	}
+
+	// First four FEN fields of an EPD line, and its "dm" operation
+	Position parseEpd(const std::string& line)
+	{
+		std::istringstream stream(line);
+		string fields[4];
+		stream >> fields[0] >> fields[1] >> fields[2] >> fields[3];
+
+		Position position;
+		position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+		position.expected = 0;
+
+		string token;
+		while (stream >> token)
+		{
+			if ("dm" == token)
+			{
+				stream >> position.expected;
+			}
+		}
+		return position;
+	}
+
+	bool loadGame(const std::string& fileName, std::vector<Position>& positions)
+	{
+		std::ifstream ifs(fileName);
+		if (!ifs)
+		{
+			return false;
+		}
+
+		std::deque<Game::Round> rounds;
+		Game::loadRounds(ifs, rounds);
+
+		Board board;
+		board.setStartPosition();
+		for (size_t i = 0; i < rounds.size(); i++)
+		{
+			const string* moves[2] = { &rounds[i].whiteMove, &rounds[i].blackMove };
+			for (int j = 0; j < 2 && !moves[j]->empty(); j++)
+			{
+				CompactMove move = board.parseRecord(*moves[j]);
+				if (move.isNull())
+				{
+					throw invalid_argument("Illegal move " + *moves[j] + " in " + fileName + "\n");
+				}
+				board.makeMove(move);
+			}
+		}
+
+		Position position = { board.toFen(), 0 };
+		positions.push_back(position);
+		return true;
+	}
+
+	void addPositions(const std::string& argument, std::vector<Position>& positions)
+	{
+		if (argument.size() > 4 && ".dat" == argument.substr(argument.size() - 4) && loadGame(argument, positions))
+		{
+			return;
+		}
+
+		std::ifstream ifs(argument);
+		if (!ifs)
+		{
+			positions.push_back(parseEpd(argument));
+			return;
+		}
+
+		string line;
+		while (std::getline(ifs, line))
+		{
+			if (!line.empty() && '#' != line[0] && string::npos != line.find('/'))
+			{
+				positions.push_back(parseEpd(line));
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int depth = 5;
+	uint64_t nodeLimit = 0;
+	size_t hashMb = MateSolver::DEFAULT_HASH_MB;
+	std::vector<Position> positions;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if (0 != option.compare(0, 2, "--"))
+			{
+				addPositions(option, positions);
+			}
+			else if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--depth" == option) depth = std::max(1, std::stoi(argv[++i]));
+			else if ("--nodes" == option) nodeLimit = std::stoull(argv[++i]);
+			else if ("--hash" == option)  hashMb = std::stoul(argv[++i]);
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+
+		if (positions.empty())
+		{
+			throw invalid_argument("No positions given\n");
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	MateSolver solver(hashMb);
+	int found = 0;
+	int wrong = 0;
+	uint64_t totalNodes = 0;
+	long long totalTime = 0;
+
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		Board board;
+		if (!board.setFromFen(positions[i].fen))
+		{
+			cout << positions[i].fen << ": invalid FEN\n";
+			wrong++;
+			continue;
+		}
+
+		cout << positions[i].fen << ": ";
+		Board::MoveList list;
+		board.generateLegalMoves(list);
+		if (0 == list.count)
+		{
+			cout << (board.isInCheck() ? "already checkmated\n" : "stalemate\n");
+			continue;
+		}
+
+		int maxMoves = std::max(depth, positions[i].expected);
+		solver.clear();
+		MateSolver::Result result = solver.solve(board, maxMoves, nodeLimit);
+		totalNodes += result.nodes;
+		totalTime += result.elapsed;
+
+		if (result.mateIn > 0)
+		{
+			found++;
+			cout << "mate in " << result.mateIn;
+
+			Board line = board;
+			for (size_t j = 0; j < result.pv.size(); j++)
+			{
+				cout << (0 == j ? " (" : " ") << line.toRecord(result.pv[j]);
+				line.makeMove(result.pv[j]);
+			}
+			cout << (result.pv.empty() ? "" : ")");
+		}
+		else
+		{
+			cout << (result.unknown ? "node limit reached" : "no mate in " + std::to_string(maxMoves));
+		}
+		cout << ", " << result.nodes << " nodes, " << result.elapsed << " ms";
+
+		if (positions[i].expected > 0 && positions[i].expected != result.mateIn)
+		{
+			cout << ", expected mate in " << positions[i].expected;
+			wrong++;
+		}
+		cout << "\n";
+	}
+
+	if (positions.size() > 1)
+	{
+		cout << "Mates found: " << found << " of " << positions.size() << ", " << totalNodes << " nodes, " << totalTime << " ms";
+		if (wrong > 0)
+		{
+			cout << ", " << wrong << " not as expected";
+		}
+		cout << "\n";
+	}
+
+	return 0 == wrong ? 0 : 1;
+}
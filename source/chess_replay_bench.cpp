@@ -0,0 +1,364 @@
+#include "game.h"
+#include "Rules.h"
+#include "Trace.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Replays saved games through the rules, checks how they end and times them:
+// chess_replay_bench [options] [DIRECTORY|GAME...]
+// What every game should end in is kept next to it, in the directory's
+// expected.txt: one line per game, "name state plies FEN", where state is
+// "illegal" when a move is refused and the FEN the position the replay stopped
+// at. --update writes the results there
+namespace
+{
+	const char* EXPECTED_FILE = "expected.txt";
+
+	struct Fixture
+	{
+		std::string directory;
+		std::string name;
+		std::deque<Game::Round> rounds;
+	};
+
+	struct Outcome
+	{
+		std::string state;  // A terminal state name, or "illegal"
+		size_t      plies;
+		std::string fen;
+		std::string error;  // Why the replay stopped, only printed
+	};
+
+	// The outcomes of the games in one directory, by file name, as written in expected.txt
+	typedef std::map<std::string, std::string> Expectations;
+
+	void printUsage(void)
+	{
+		cout << "Usage: chess_replay_bench [options] [DIRECTORY|GAME...]\n"
+			<< "  DIRECTORY            Every .dat in it (default test)\n"
+			<< "  GAME                 One saved game\n"
+			<< "  --time MS            Least time spent replaying each game (default 100)\n"
+			<< "  --update             Write the outcomes to the expected.txt of every directory\n";
+	}
+
+	bool isDirectory(const std::string& path)
+	{
+#ifdef _WIN32
+		DWORD attributes = GetFileAttributesA(path.c_str());
+		return INVALID_FILE_ATTRIBUTES != attributes && 0 != (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+		struct stat info;
+		return 0 == stat(path.c_str(), &info) && S_ISDIR(info.st_mode);
+#endif
+	}
+
+	// The .dat files of the directory, sorted by name
+	std::vector<std::string> listGames(const std::string& directory)
+	{
+		std::vector<std::string> names;
+#ifdef _WIN32
+		WIN32_FIND_DATAA found;
+		HANDLE search = FindFirstFileA((directory + "\\*.dat").c_str(), &found);
+		if (INVALID_HANDLE_VALUE != search)
+		{
+			do
+			{
+				names.push_back(found.cFileName);
+			} while (FindNextFileA(search, &found));
+			FindClose(search);
+		}
+#else
+		DIR* dir = opendir(directory.c_str());
+		if (NULL == dir)
+		{
+			throw invalid_argument("Can't open the directory " + directory + "\n");
+		}
+		for (struct dirent* entry = readdir(dir); NULL != entry; entry = readdir(dir))
+		{
+			string name = entry->d_name;
+			if (name.size() > 4 && 0 == name.compare(name.size() - 4, 4, ".dat"))
+			{
+				names.push_back(name);
+			}
+		}
+		closedir(dir);
+#endif
+		std::sort(names.begin(), names.end());
+		return names;
+	}
+
+	void loadFixture(const std::string& directory, const std::string& name, std::vector<Fixture>& fixtures)
+	{
+		string path = directory + "/" + name;
+		std::ifstream ifs(path);
+		if (!ifs)
+		{
+			throw invalid_argument("Can't open " + path + "\n");
+		}
+
+		fixtures.push_back(Fixture());
+		Fixture& fixture = fixtures.back();
+		fixture.directory = directory;
+		fixture.name = name;
+		Game::loadRounds(ifs, fixture.rounds);
+	}
+
+	void loadExpectations(const std::string& directory, Expectations& expectations)
+	{
+		std::ifstream ifs(directory + "/" + EXPECTED_FILE);
+		string line;
+		int lineNumber = 0;
+		while (std::getline(ifs, line))
+		{
+			lineNumber++;
+
+			std::istringstream stream(line);
+			string name;
+			string state;
+			if (!(stream >> name >> state) || '#' == name[0])
+			{
+				continue;
+			}
+
+			Chess::TerminalState terminal;
+			if ("illegal" != state && !Chess::parseTerminalState(state, terminal))
+			{
+				throw invalid_argument(directory + "/" + EXPECTED_FILE + " line " + std::to_string(lineNumber) + ": unknown state " + state + "\n");
+			}
+
+			string rest;
+			std::getline(stream >> std::ws, rest);
+			expectations[name] = state + " " + rest;
+		}
+	}
+
+	void saveExpectations(const std::string& directory, const Expectations& expectations)
+	{
+		string path = directory + "/" + EXPECTED_FILE;
+		std::ofstream ofs(path);
+		if (!ofs)
+		{
+			throw invalid_argument("Can't write " + path + "\n");
+		}
+
+		ofs << "# How the games of this directory end: name state plies FEN (chess_replay_bench --update)\n";
+		for (Expectations::const_iterator it = expectations.begin(); it != expectations.end(); ++it)
+		{
+			ofs << it->first << " " << it->second << "\n";
+		}
+	}
+
+	Outcome replay(const Fixture& fixture, Game& game)
+	{
+		game.reset();
+
+		Outcome outcome;
+		bool legal = Rules::replay(game, fixture.rounds, outcome.error);
+
+		Board board;
+		std::vector<uint64_t> history;
+		game.toBoard(board, history);
+		outcome.state = legal ? Chess::terminalStateName(game.terminalState()) : "illegal";
+		outcome.plies = game.getPlyCount();
+		outcome.fen = board.toFen();
+		return outcome;
+	}
+
+	string formatOutcome(const Outcome& outcome)
+	{
+		return outcome.state + " " + std::to_string(outcome.plies) + " " + outcome.fen;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	long long minimumTime = 100;
+	bool update = false;
+	std::vector<std::string> paths;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if ("--update" == option)
+			{
+				update = true;
+			}
+			else if (0 != option.compare(0, 2, "--"))
+			{
+				paths.push_back(option);
+			}
+			else if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--time" == option) minimumTime = std::max(0LL, std::stoll(argv[++i]));
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	if (paths.empty())
+	{
+		paths.push_back("test");
+	}
+
+	Trace::writeAtExit();
+
+	std::vector<Fixture> fixtures;
+	std::map<std::string, Expectations> expectations;
+	try
+	{
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			if (isDirectory(paths[i]))
+			{
+				std::vector<std::string> names = listGames(paths[i]);
+				for (size_t j = 0; j < names.size(); j++)
+				{
+					loadFixture(paths[i], names[j], fixtures);
+				}
+			}
+			else
+			{
+				size_t slash = paths[i].find_last_of("/\\");
+				string directory = string::npos == slash ? "." : paths[i].substr(0, slash);
+				loadFixture(directory, paths[i].substr(string::npos == slash ? 0 : slash + 1), fixtures);
+			}
+		}
+
+		for (size_t i = 0; i < fixtures.size(); i++)
+		{
+			if (0 == expectations.count(fixtures[i].directory))
+			{
+				loadExpectations(fixtures[i].directory, expectations[fixtures[i].directory]);
+			}
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		return 1;
+	}
+
+	if (fixtures.empty())
+	{
+		cout << "No games found\n";
+		return 1;
+	}
+
+	Game game;
+	int failed = 0;
+	int unchecked = 0;
+	uint64_t totalPlies = 0;
+	long long totalTime = 0;
+
+	cout << std::left << std::setw(34) << "Game" << std::right << std::setw(7) << "Plies" << "  " << std::left << std::setw(12) << "State" << std::setw(8) << "Check" << std::right << std::setw(12) << "Moves/s" << "\n";
+	for (size_t i = 0; i < fixtures.size(); i++)
+	{
+		const Fixture& fixture = fixtures[i];
+		Outcome outcome = replay(fixture, game);
+
+		// Against the expectation
+		Expectations& expected = expectations[fixture.directory];
+		Expectations::const_iterator found = expected.find(fixture.name);
+		string check;
+		if (update)
+		{
+			check = expected.end() == found ? "added" : found->second == formatOutcome(outcome) ? "ok" : "updated";
+			expected[fixture.name] = formatOutcome(outcome);
+		}
+		else if (expected.end() == found)
+		{
+			check = "none";
+			unchecked++;
+		}
+		else if (found->second == formatOutcome(outcome))
+		{
+			check = "ok";
+		}
+		else
+		{
+			check = "FAIL";
+			failed++;
+		}
+
+		// The same replay again until the time is up
+		uint64_t plies = 0;
+		auto start = std::chrono::steady_clock::now();
+		long long elapsed = 0;
+		do
+		{
+			plies += replay(fixture, game).plies;
+			elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		} while (elapsed < minimumTime * 1000000LL);
+		totalPlies += plies;
+		totalTime += elapsed;
+
+		cout << std::left << std::setw(34) << fixture.name << std::right << std::setw(7) << outcome.plies << "  "
+			<< std::left << std::setw(12) << outcome.state << std::setw(8) << check << std::right
+			<< std::setw(12) << (elapsed > 0 ? plies * 1000000000ULL / uint64_t(elapsed) : 0) << "\n";
+		if ("FAIL" == check)
+		{
+			cout << "    expected: " << found->second << "\n"
+				<< "    got     : " << formatOutcome(outcome) << "\n";
+		}
+		if (!outcome.error.empty())
+		{
+			cout << "    " << outcome.error << "\n";
+		}
+	}
+
+	cout << "Games    : " << fixtures.size() << " (" << failed << " failed, " << unchecked << " without an expectation)\n";
+	cout << "Moves    : " << totalPlies << " in " << totalTime / 1000000 << " ms";
+	if (totalTime > 0)
+	{
+		cout << ", " << totalPlies * 1000000000ULL / uint64_t(totalTime) << " moves/second";
+	}
+	cout << "\n";
+
+	if (update)
+	{
+		try
+		{
+			for (std::map<std::string, Expectations>::const_iterator it = expectations.begin(); it != expectations.end(); ++it)
+			{
+				saveExpectations(it->first, it->second);
+				cout << "Wrote " << it->first << "/" << EXPECTED_FILE << "\n";
+			}
+		}
+		catch (invalid_argument& error)
+		{
+			cout << error.what();
+			return 1;
+		}
+	}
+
+	return failed > 0 ? 1 : 0;
+}
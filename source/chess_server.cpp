@@ -0,0 +1,102 @@
+#include "GameServer.h"
+#include "Counters.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
+#include <signal.h>
+
+// Game server: chess_server --socket /tmp/chess.sock --workers 4
+namespace
+{
+	GameServer* running = NULL;
+
+	void printUsage(void)
+	{
+		GameServer::Settings defaults;
+		cout << "Usage: chess_server [options]\n"
+			<< "  --socket PATH        Unix domain socket to listen on (default " << defaults.socketPath << ")\n"
+			<< "  --games DIR          Directory of the games saved and loaded by name (default " << defaults.gamesDirectory << ")\n"
+			<< "  --workers N          Threads running the commands (default " << defaults.workers << ")\n"
+			<< "  --sessions N         Games allocated up front (default " << defaults.sessions << ")\n"
+			<< "  --clients N          Most clients connected at once (default " << defaults.maxClients << ")\n"
+			<< "  --queue N            Commands that can wait for each worker (default " << defaults.queueSize << ")\n"
+			<< "  --pin                Keep every worker on its own core\n"
+			<< "Commands, one per line: new, move ID e2 e4 [Q], undo ID, state ID, save ID NAME, load NAME, close ID, stats, quit\n";
+	}
+
+	void onSignal(int)
+	{
+		if (NULL != running)
+		{
+			running->stop();
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	GameServer::Settings settings;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if ("--pin" == option)
+			{
+				settings.pinWorkers = true;
+			}
+			else if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--socket" == option)   settings.socketPath = argv[++i];
+			else if ("--games" == option)    settings.gamesDirectory = argv[++i];
+			else if ("--workers" == option)  settings.workers = std::max(1, std::stoi(argv[++i]));
+			else if ("--sessions" == option) settings.sessions = std::stoul(argv[++i]);
+			else if ("--clients" == option)  settings.maxClients = std::stoul(argv[++i]);
+			else if ("--queue" == option)    settings.queueSize = std::max<size_t>(2, std::stoul(argv[++i]));
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	Counters::dumpAtExit();
+	AllocationTracker::reportAtExit();
+	Trace::writeAtExit();
+
+	GameServer server(settings);
+	running = &server;
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	try
+	{
+		cout << "Listening on " << settings.socketPath << " with " << settings.workers << " workers\n";
+		server.run();
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		return 1;
+	}
+
+	running = NULL;
+	cout << "Server stopped\n";
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "Tablebase.h"
+#include <thread>
+
+// Endgame tablebase generator: chess_tbgen KQK KRK KBNK KQKR --out tables
+namespace
+{
+	void printUsage(void)
+	{
+		cout << "Usage: chess_tbgen MATERIAL... [options]\n"
+			<< "  MATERIAL             White then black pieces with their kings, e.g. KQK or KRKN; \"all\" for every table\n"
+			<< "  --threads N          Default: all cores\n"
+			<< "  --out DIR            Where to save the tables (default: current directory)\n"
+			<< "Tables that are already in the directory are kept. Those reached by captures and promotions are generated too\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> signatures;
+	int threads = std::max(1, int(std::thread::hardware_concurrency()));
+	string directory = ".";
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			string option = argv[i];
+			if ("--help" == option)
+			{
+				printUsage();
+				return 0;
+			}
+			else if ('-' != option[0])
+			{
+				if ("all" == option)
+				{
+					std::vector<std::string> all = Tablebases::allSignatures();
+					signatures.insert(signatures.end(), all.begin(), all.end());
+				}
+				else
+				{
+					signatures.push_back(option);
+				}
+			}
+			else if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--threads" == option) threads = std::max(1, std::stoi(argv[++i]));
+			else if ("--out" == option)     directory = argv[++i];
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+
+		if (signatures.empty())
+		{
+			throw invalid_argument("No material given\n");
+		}
+
+		Tablebases tablebases;
+		int loaded = tablebases.load(directory);
+		if (loaded > 0)
+		{
+			cout << "Found " << loaded << " tables in " << directory << "\n";
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < signatures.size(); i++)
+		{
+			tablebases.generate(signatures[i], threads, cout, directory);
+		}
+		cout << "Done in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include "Tuner.h"
+
+// Evaluation tuner: chess_tune positions.epd --epochs 2000 --out weights.txt
+namespace
+{
+	void printUsage(void)
+	{
+		cout << "Usage: chess_tune POSITIONS [options]\n"
+			<< "  POSITIONS            One \"FEN result\" per line, result as 1-0, 0-1, 1/2-1/2 or [1.0], [0.5], [0.0]\n"
+			<< "  --epochs N           Gradient steps over the whole set (default 1000)\n"
+			<< "  --threads N          Default: all cores\n"
+			<< "  --lr X               Step size in centipawns (default 1.0)\n"
+			<< "  --k X                Sigmoid scale, fitted to the start weights when not given\n"
+			<< "  --weights FILE       Start from these weights instead of the built-in ones\n"
+			<< "  --out FILE           Where to save the weights (default weights.txt)\n"
+			<< "  --report N           Epochs between progress lines and saves (default 50)\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2 || '-' == argv[1][0])
+	{
+		printUsage();
+		return 1;
+	}
+
+	Tuner tuner;
+	Tuner::Settings settings;
+	string weightsFile;
+
+	try
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			string option = argv[i];
+			if (i + 1 >= argc)
+			{
+				throw invalid_argument("Missing value for " + option + "\n");
+			}
+			else if ("--epochs" == option)  settings.epochs = std::stoi(argv[++i]);
+			else if ("--threads" == option) tuner.setThreads(std::stoi(argv[++i]));
+			else if ("--lr" == option)      settings.learningRate = std::stod(argv[++i]);
+			else if ("--k" == option)       settings.k = std::stod(argv[++i]);
+			else if ("--weights" == option) weightsFile = argv[++i];
+			else if ("--out" == option)     settings.outputFile = argv[++i];
+			else if ("--report" == option)  settings.reportInterval = std::max(1, std::stoi(argv[++i]));
+			else throw invalid_argument("Unknown option " + option + "\n");
+		}
+
+		if (!weightsFile.empty())
+		{
+			Evaluation evaluation;
+			if (!evaluation.loadWeights(weightsFile))
+			{
+				throw invalid_argument("Error loading weights from " + weightsFile + "\n");
+			}
+			tuner.setWeights(evaluation);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		if (0 == tuner.load(argv[1]))
+		{
+			throw invalid_argument(string("No usable positions in ") + argv[1] + "\n");
+		}
+		cout << "Loaded in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+
+		tuner.run(settings, cout);
+	}
+	catch (invalid_argument& error)
+	{
+		cout << error.what();
+		printUsage();
+		return 1;
+	}
+	catch (std::logic_error&)
+	{
+		cout << "Invalid number in the options\n";
+		printUsage();
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,249 +1,108 @@
 #include "game.h"
 #include "chess.h"
 #include "includes.h"
-#include "user_interface.h"
+#include "Board.h"
+#include "Counters.h"
+#include "AllocationTracker.h"
 
 Game::Game()
 {
-	// White player always starts
-	currentTurn = WHITE_PLAYER;
+	reset();
+}
 
-	// Game on!
-	gameFinished = false;
+Game::~Game()
+{
+}
 
-	// Nothing has happend yet
-	undoMove.initFalse();
+void Game::reset(void)
+{
+	// The containers keep their memory, so a reused game does not allocate again
+	history.plies.clear();
+	history.keys.clear();
+	history.captured[WHITE_PIECE].clear();
+	history.captured[BLACK_PIECE].clear();
 
-	// Initial board settings
-	memcpy(board, initial_board, sizeof(char) * 8 * 8);
+	// Nothing has happend yet
+	history.undo = false;
 
-	// Castling is allowed (to each side) until the player moves the king or the rook
-	initCastlingTrue();
-}
+	// Game on!
+	gameFinished = false;
 
-Game::~Game()
-{
-	whiteCaptured.clear();
-	blackCaptured.clear();
-	rounds.clear();
+	// Initial board settings, white to move and every castling allowed
+	position.setStartPosition();
 }
 
 void Game::movePiece(Move* currentMove)
 {
+	CHESS_ALLOC_SCOPE(HISTORY);
+
 	// Get the piece to be moved
 	char piece = getPieceAtPosition(currentMove->getPresent());
 
 	// Is the destination square occupied?
 	char chCapturedPiece = getPieceAtPosition(currentMove->getFuture());
 
-	// So, was a piece captured in this move?
+	// The history keeps the squares and what kind of move it was
+	CompactMove ply = CompactMove::null();
+	ply.from = uint8_t(Board::makeSquare(currentMove->getPresent().row, currentMove->getPresent().column));
+	ply.to = uint8_t(Board::makeSquare(currentMove->getFuture().row, currentMove->getFuture().column));
+	ply.flags = 0;
 	if (chCapturedPiece != EMPTY_SQUARE)
 	{
-		if (WHITE_PIECE == getPieceColor(chCapturedPiece))
-		{
-			// A white piece was captured
-			whiteCaptured.push_back(chCapturedPiece);
-		}
-		else
-		{
-			// A black piece was captured
-			blackCaptured.push_back(chCapturedPiece);
-		}
-
-		// Set Undo structure. If a piece was captured, then no "en passant" move performed
-		undoMove.lastMoveCaptured = true;
-
-		// Reset undoMove.castling
-		memset(&undoMove.enPassant, 0, sizeof(Chess::EnPassant));
+		ply.flags |= CompactMove::FLAG_CAPTURE;
 	}
-	else if (currentMove->getEnPassant()->applied)
+	if (currentMove->getEnPassant()->applied)
 	{
-		char chCapturedEP = getPieceAtPosition(currentMove->getEnPassant()->PawnCaptured.row, currentMove->getEnPassant()->PawnCaptured.column);
-
-		if (WHITE_PIECE == getPieceColor(chCapturedEP))
-		{
-			// A white piece was captured
-			whiteCaptured.push_back(chCapturedEP);
-		}
-		else
-		{
-			// A black piece was captured
-			blackCaptured.push_back(chCapturedEP);
-		}
-
-		// Now, remove the captured pawn
-		board[currentMove->getEnPassant()->PawnCaptured.row][currentMove->getEnPassant()->PawnCaptured.column] = EMPTY_SQUARE;
-
-		// Set Undo structure as piece was captured and "en passant" move was performed
-		undoMove.lastMoveCaptured = true;
-		memcpy(&undoMove.enPassant, currentMove->getEnPassant(), sizeof(Chess::EnPassant));
+		ply.flags |= CompactMove::FLAG_EN_PASSANT;
 	}
-	else
+	if (currentMove->getCastling()->applied)
 	{
-		undoMove.lastMoveCaptured = false;
-
-		// Reset undoMove.castling
-		memset(&undoMove.enPassant, 0, sizeof(Chess::EnPassant));
+		ply.flags |= CompactMove::FLAG_CASTLING;
 	}
-
-	// Remove piece from currentMove->getPresent() position
-	board[currentMove->getPresent().row][currentMove->getPresent().column] = EMPTY_SQUARE;
-
-	// Move piece to new position
 	if (currentMove->getPromotion()->applied)
 	{
-		board[currentMove->getFuture().row][currentMove->getFuture().column] = currentMove->getPromotion()->after;
-
-		// Set Undo structure as a promotion occured
-		memcpy(&undoMove.promotion, currentMove->getPromotion(), sizeof(Chess::Promotion));
+		ply.flags |= CompactMove::FLAG_PROMOTION;
+		ply.promotion = char(toupper(currentMove->getPromotion()->after));
 	}
-	else
+	else if (Chess::PIECE_TYPE_PAWN == toupper(piece) && 2 == abs(currentMove->getFuture().row - currentMove->getPresent().row))
 	{
-		board[currentMove->getFuture().row][currentMove->getFuture().column] = piece;
-
-		// Reset undoMove.promotion
-		memset(&undoMove.promotion, 0, sizeof(Chess::Promotion));
+		ply.flags |= CompactMove::FLAG_DOUBLE_PUSH;
 	}
 
-	// Was it a castling move?
-	if (currentMove->getCastling()->applied)
-	{
-		// The king was already move, but we still have to move the rook to 'jump' the king
-		char piece = getPieceAtPosition(currentMove->getCastling()->rookBefore.row, currentMove->getCastling()->rookBefore.column);
-
-		// Remove the rook from currentMove->getPresent() position
-		board[currentMove->getCastling()->rookBefore.row][currentMove->getCastling()->rookBefore.column] = EMPTY_SQUARE;
-
-		// 'Jump' into to new position
-		board[currentMove->getCastling()->rookAfter.row][currentMove->getCastling()->rookAfter.column] = piece;
-
-		// Write this information to the undoMove struct
-		memcpy(&undoMove.castling, currentMove->getCastling(), sizeof(Chess::Castling));
-
-		// Save the 'isCastlingAllowed' information in case the move is undone
-		undoMove.allowedCastlingKingSide = castlingKingSideAllowed[getCurrentTurn()];
-		undoMove.allowedCastlingQueenSide = castlingQueenSideAllowed[getCurrentTurn()];
-	}
-	else
-	{
-		// Reset undoMove.castling
-		memset(&undoMove.castling, 0, sizeof(Chess::Castling));
-	}
-
-	// Castling requirements
-	if (Chess::PIECE_TYPE_KING == toupper(piece))
+	// So, was a piece captured in this move?
+	if (chCapturedPiece != EMPTY_SQUARE)
 	{
-		// After the king has moved once, no more castling allowed
-		castlingKingSideAllowed[getCurrentTurn()] = false;
-		castlingQueenSideAllowed[getCurrentTurn()] = false;
+		history.captured[getPieceColor(chCapturedPiece)].push_back(chCapturedPiece);
 	}
-	else if (Chess::PIECE_TYPE_ROOK == toupper(piece))
+	else if (currentMove->getEnPassant()->applied)
 	{
-		// If the rook moved from column 'A', no more castling allowed on the queen side
-		if (0 == currentMove->getPresent().column)
-		{
-			castlingQueenSideAllowed[getCurrentTurn()] = false;
-		}
-
-		// If the rook moved from column 'A', no more castling allowed on the queen side
-		else if (7 == currentMove->getPresent().column)
-		{
-			castlingKingSideAllowed[getCurrentTurn()] = false;
-		}
+		char chCapturedEP = getPieceAtPosition(currentMove->getEnPassant()->PawnCaptured.row, currentMove->getEnPassant()->PawnCaptured.column);
+		history.captured[getPieceColor(chCapturedEP)].push_back(chCapturedEP);
 	}
 
-	// Change turns
-	changeTurns();
-
 	// This move can be undone
-	undoMove.undo = true;
+	history.plies.push_back(ply);
+	history.keys.push_back(position.hash);
+	history.beforeLast = position;
+	history.undo = true;
+
+	// The board takes the rook along when castling, removes a pawn taken en passant,
+	// updates the castling rights and the clocks, and changes turns
+	position.makeMove(ply);
 }
 
 void Game::undoLastMove()
 {
-	string last_move = getLastMove();
-
-	// Parse the line
-	Chess::Position from;
-	Chess::Position to;
-	parseMove(last_move, &from, &to);
-
-	// Since we want to undo a move, we will be moving the piece from (iToRow, iToColumn) to (iFromRow, iFromColumn)
-	char piece = getPieceAtPosition(to.row, to.column);
-
-	// Moving it back
-	// If there was a castling
-	if (undoMove.promotion.applied)
-	{
-		board[from.row][from.column] = undoMove.promotion.before;
-	}
-	else
-	{
-		board[from.row][from.column] = piece;
-	}
-
-	// Change turns
-	changeTurns();
-
-	// If a piece was captured, move it back to the board
-	if (undoMove.lastMoveCaptured)
-	{
-		// Let's retrieve the last captured piece
-		char chCaptured;
-
-		// Since we already changed turns back, it means we should we pop a piece from the oponents vector
-		if (WHITE_PLAYER == currentTurn)
-		{
-			chCaptured = blackCaptured.back();
-			blackCaptured.pop_back();
-		}
-		else
-		{
-			chCaptured = whiteCaptured.back();
-			whiteCaptured.pop_back();
-		}
-
-		// Move the captured piece back. Was this an "en passant" move?
-		if (undoMove.enPassant.applied)
-		{
-			// Move the captured piece back
-			board[undoMove.enPassant.PawnCaptured.row][undoMove.enPassant.PawnCaptured.column] = chCaptured;
-
-			// Remove the attacker
-			board[to.row][to.column] = EMPTY_SQUARE;
-		}
-		else
-		{
-			board[to.row][to.column] = chCaptured;
-		}
-	}
-	else
-	{
-		board[to.row][to.column] = EMPTY_SQUARE;
-	}
+	// The position goes back as a whole, captured piece and castling rights included
+	position = history.beforeLast;
 
-	// If there was a castling
-	if (undoMove.castling.applied)
+	// The piece was taken from the side that did not move
+	if (history.plies.back().isCapture())
 	{
-		char chRook = getPieceAtPosition(undoMove.castling.rookAfter.row, undoMove.castling.rookAfter.column);
-
-		// Remove the rook from present position
-		board[undoMove.castling.rookAfter.row][undoMove.castling.rookAfter.column] = EMPTY_SQUARE;
-
-		// 'Jump' into to new position
-		board[undoMove.castling.rookBefore.row][undoMove.castling.rookBefore.column] = chRook;
-
-		// Restore the values of castling allowed or not
-		castlingKingSideAllowed[getCurrentTurn()] = undoMove.allowedCastlingKingSide;
-		castlingQueenSideAllowed[getCurrentTurn()] = undoMove.allowedCastlingQueenSide;
+		history.captured[getOpponentColor()].pop_back();
 	}
 
-	// Clean undoMove struct
-	undoMove.undo = false;
-	undoMove.lastMoveCaptured = false;
-	undoMove.enPassant.applied = false;
-	undoMove.castling.applied = false;
-	undoMove.promotion.applied = false;
+	history.undo = false;
 
 	// If it was a checkmate, toggle back to game not finished
 	gameFinished = false;
@@ -254,35 +113,39 @@ void Game::undoLastMove()
 
 bool Game::isUndoPossible()
 {
-	return undoMove.undo;
+	return history.undo;
 }
 
 bool Game::isCastlingAllowed(Chess::Side side, int color)
 {
+	int right;
 	if (side == Side::QUEEN_SIDE)
 	{
-		return castlingQueenSideAllowed[color];
+		right = WHITE_PLAYER == color ? Board::CASTLE_WHITE_QUEEN : Board::CASTLE_BLACK_QUEEN;
 	}
 	else //if ( KING_SIDE == side )
 	{
-		return castlingKingSideAllowed[color];
+		right = WHITE_PLAYER == color ? Board::CASTLE_WHITE_KING : Board::CASTLE_BLACK_KING;
 	}
+	return 0 != (position.castlingRights & right);
 }
 
 char Game::getPieceAtPosition(int row, int column)
 {
-	return board[row][column];
+	return position.squares[Board::makeSquare(row, column)];
 }
 
-char Game::getPieceAtPosition(Position position)
+char Game::getPieceAtPosition(Position square)
 {
-	return board[position.row][position.column];
+	return position.squares[Board::makeSquare(square.row, square.column)];
 }
 
 char Game::considerMove(int row, int column, IntendedMove* intendedMove)
 {
 	char piece;
 
+	CHESS_COUNT(SQUARES_SCANNED);
+
 	// If there is no intended move, just return the current position of the board
 	if (nullptr == intendedMove)
 	{
@@ -295,11 +158,13 @@ char Game::considerMove(int row, int column, IntendedMove* intendedMove)
 		if (intendedMove->from.row == row && intendedMove->from.column == column)
 		{
 			// The piece wants to move from that square, so it would be empty
+			CHESS_COUNT(OVERLAY_HITS);
 			piece = EMPTY_SQUARE;
 		}
 		else if (intendedMove->to.row == row && intendedMove->to.column == column)
 		{
 			// The piece wants to move to that square, so return the piece
+			CHESS_COUNT(OVERLAY_HITS);
 			piece = intendedMove->piece;
 		}
 		else
@@ -691,6 +556,8 @@ Chess::UnderAttack Game::underAttack(Chess::Position currentPosition, int color,
 {
 	UnderAttack attack = { 0 };
 
+	CHESS_COUNT(UNDER_ATTACK);
+
 	this->checkUnderAttackHorizontal(currentPosition, color, intendedMove, attack);
 	this->checkUnderAttackVertical(currentPosition, color, intendedMove, attack);
 	this->checkUnderAttackDiagonal(currentPosition, color, intendedMove, attack);
@@ -996,6 +863,8 @@ bool Game::isReachable(Chess::Position currentPosition, int color)
 {
 	bool bReachable = false;
 
+	CHESS_COUNT(IS_REACHABLE);
+
 	this->checkReachableHorizontal(currentPosition, color, bReachable);
 	this->checkReachableVertical(currentPosition, color, bReachable);
 	this->checkReachableDiagonal(currentPosition, color, bReachable);
@@ -1022,7 +891,7 @@ void Game::isPathFreeHorizontal(Position starting, Position finishing, bool& bFr
 		// If the piece wants to move from column 0 to column 7, we must check if columns 1-6 are free
 	if (starting.column == finishing.column)
 	{
-		cout << "Error. Movement is horizontal but column is the same\n";
+		throw("Error. Movement is horizontal but column is the same");
 	}
 
 	// Moving to the right
@@ -1036,7 +905,6 @@ void Game::isPathFreeHorizontal(Position starting, Position finishing, bool& bFr
 			if (isSquareOccupied(starting.row, i))
 			{
 				bFree = false;
-				cout << "Horizontal path to the right is not clear!\n";
 			}
 		}
 	}
@@ -1052,7 +920,6 @@ void Game::isPathFreeHorizontal(Position starting, Position finishing, bool& bFr
 			if (isSquareOccupied(starting.row, i))
 			{
 				bFree = false;
-				cout << "Horizontal path to the left is not clear!\n";
 			}
 		}
 	}
@@ -1064,7 +931,6 @@ void Game::isPathFreeVertical(Position starting, Position finishing, bool& bFree
 		// If the piece wants to move from column 0 to column 7, we must check if columns 1-6 are free
 	if (starting.row == finishing.row)
 	{
-		cout << "Error. Movement is vertical but row is the same\n";
 		throw("Error. Movement is vertical but row is the same");
 	}
 
@@ -1079,7 +945,6 @@ void Game::isPathFreeVertical(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(i, starting.column))
 			{
 				bFree = false;
-				cout << "Vertical path up is not clear!\n";
 			}
 		}
 	}
@@ -1095,7 +960,6 @@ void Game::isPathFreeVertical(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(i, starting.column))
 			{
 				bFree = false;
-				cout << "Vertical path down is not clear!\n";
 			}
 		}
 	}
@@ -1114,7 +978,6 @@ void Game::isPathFreeDiagonal(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(starting.row + i, starting.column + i))
 			{
 				bFree = false;
-				cout << "Diagonal path up-right is not clear!\n";
 			}
 		}
 	}
@@ -1130,7 +993,6 @@ void Game::isPathFreeDiagonal(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(starting.row + i, starting.column - i))
 			{
 				bFree = false;
-				cout << "Diagonal path up-left is not clear!\n";
 			}
 		}
 	}
@@ -1146,7 +1008,6 @@ void Game::isPathFreeDiagonal(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(starting.row - i, starting.column + i))
 			{
 				bFree = false;
-				cout << "Diagonal path down-right is not clear!\n";
 			}
 		}
 	}
@@ -1162,7 +1023,6 @@ void Game::isPathFreeDiagonal(Position starting, Position finishing, bool& bFree
 			if (isSquareOccupied(starting.row - i, starting.column - i))
 			{
 				bFree = false;
-				cout << "Diagonal path down-left is not clear!\n";
 			}
 		}
 	}
@@ -1207,7 +1067,7 @@ void Game::canBeBlockedHorizontal(Position starting, Position finishing, bool& b
 		// If the piece wants to move from column 0 to column 7, we must check if columns 1-6 are free
 	if (starting.column == finishing.column)
 	{
-		cout << "Error. Movement is horizontal but column is the same\n";
+		throw("Error. Movement is horizontal but column is the same");
 	}
 
 	// Moving to the right
@@ -1245,7 +1105,6 @@ void Game::canBeBlockedVertical(Position starting, Position finishing, bool& bBl
 		// If the piece wants to move from column 0 to column 7, we must check if columns 1-6 are free
 	if (starting.row == finishing.row)
 	{
-		cout << "Error. Movement is vertical but row is the same\n";
 		throw("Error. Movement is vertical but row is the same");
 	}
 
@@ -1338,7 +1197,6 @@ void Game::canBeBlockedDiagonal(Position starting, Position finishing, bool& bBl
 
 	else
 	{
-		cout << "Error. Diagonal move not allowed\n";
 		throw("Error. Diagonal move not allowed");
 	}
 }
@@ -1571,15 +1429,88 @@ Chess::Position Game::findKing(int color)
 	return king;
 }
 
-void Game::changeTurns(void)
+Chess::TerminalState Game::terminalState(void) const
+{
+	// The engine board knows the draw rules
+	return position.terminalState(history.keys);
+}
+
+void Game::toBoard(Board& board, std::vector<uint64_t>& keys) const
+{
+	board = position;
+	keys = history.keys;
+}
+
+std::string Game::getRecord(size_t index) const
 {
-	if (WHITE_PLAYER == currentTurn)
+	// Moves without a promotion are padded, so the columns of a saved game line up
+	std::string record = Board::toRecord(history.plies[index]);
+	record.resize(7, ' ');
+	return record;
+}
+
+void Game::save(std::ostream& os) const
+{
+	writeSaveTime(os);
+
+	// Two plies per line
+	for (size_t i = 0; i < history.plies.size(); i += 2)
 	{
-		currentTurn = BLACK_PLAYER;
+		os << getRecord(i) << " | " << (i + 1 < history.plies.size() ? getRecord(i + 1) : std::string()) << "\n";
 	}
-	else
+}
+
+void Game::writeSaveTime(std::ostream& os)
+{
+	// Write the date and time of save operation
+	auto time_now = std::chrono::system_clock::now();
+	std::time_t end_time = std::chrono::system_clock::to_time_t(time_now);
+	os << "[Chess console] Saved at: " << std::ctime(&end_time);
+}
+
+void Game::saveRounds(std::ostream& os, const std::deque<Round>& rounds)
+{
+	writeSaveTime(os);
+
+	// Write the moves
+	for (unsigned i = 0; i < rounds.size(); i++)
 	{
-		currentTurn = WHITE_PLAYER;
+		os << rounds[i].whiteMove.c_str() << " | " << rounds[i].blackMove.c_str() << "\n";
+	}
+}
+
+void Game::loadRounds(std::istream& is, std::deque<Round>& rounds, std::vector<std::string>* tags)
+{
+	std::string line;
+
+	while (std::getline(is, line))
+	{
+		// Skip lines that starts with "[", but keep them for the caller
+		if (!line.compare(0, 1, "["))
+		{
+			if (tags)
+			{
+				tags->push_back(line);
+			}
+			continue;
+		}
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		// There might be one or two moves in the line, separated by " | "
+		Round round;
+		std::size_t separator = line.find("|");
+
+		round.whiteMove = line.substr(0, line.find(" |"));
+		if (std::string::npos != separator && separator + 2 < line.length())
+		{
+			round.blackMove = line.substr(separator + 2);
+		}
+
+		rounds.push_back(round);
 	}
 }
 
@@ -1590,7 +1521,7 @@ bool Game::isFinished(void)
 
 int Game::getCurrentTurn(void)
 {
-	return currentTurn;
+	return position.sideToMove;
 }
 
 int Game::getOpponentColor(void)
@@ -1637,88 +1568,8 @@ void Game::parseMove(string move, Position* from, Position* to, char* promoted)
 	}
 }
 
-void Game::logMove(std::string& record)
-{
-	// If record contains only 5 chracters, add spaces
-	// Because when 
-	if (record.length() == 5)
-	{
-		record += "  ";
-	}
-
-	if (WHITE_PLAYER == getCurrentTurn())
-	{
-		// If this was a white player move, create a new round and leave the blackMove empty
-		Round round;
-		round.whiteMove = record;
-		round.blackMove = "";
-
-		rounds.push_back(round);
-	}
-	else
-	{
-		// If this was a blackMove, just update the last Round
-		Round round = rounds[rounds.size() - 1];
-		round.blackMove = record;
-
-		// Remove the last round and put it back, now with the black move
-		rounds.pop_back();
-		rounds.push_back(round);
-	}
-}
-
-string Game::getLastMove(void)
-{
-	string last_move;
-
-	// Who did the last move?
-	if (BLACK_PLAYER == getCurrentTurn())
-	{
-		// If it's black's turn now, white had the last move
-		last_move = rounds[rounds.size() - 1].whiteMove;
-	}
-	else
-	{
-		// Last move was black's
-		last_move = rounds[rounds.size() - 1].blackMove;
-	}
-
-	return last_move;
-}
-
 void Game::deleteLastMove(void)
 {
-	// Notice we already changed turns back
-	if (WHITE_PLAYER == getCurrentTurn())
-	{
-		// Last move was white's turn, so simply pop from the back
-		rounds.pop_back();
-	}
-	else
-	{
-		// Last move was black's, so let's 
-		Round round = rounds[rounds.size() - 1];
-		round.blackMove = "";
-
-		// Pop last round and put it back, now without the black move
-		rounds.pop_back();
-		rounds.push_back(round);
-	}
-}
-
-void Game::initCastlingTrue(void) {
-	castlingKingSideAllowed[WHITE_PLAYER] = true;
-	castlingKingSideAllowed[BLACK_PLAYER] = true;
-
-	castlingQueenSideAllowed[WHITE_PLAYER] = true;
-	castlingQueenSideAllowed[BLACK_PLAYER] = true;
-}
-
-void Game::Undo::initFalse(void) {
-	this->undo = false;
-	this->lastMoveCaptured = false;
-	this->allowedCastlingKingSide = false;
-	this->allowedCastlingQueenSide = false;
-	this->enPassant.applied = false;
-	this->castling.applied = false;
+	history.plies.pop_back();
+	history.keys.pop_back();
 }
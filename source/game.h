@@ -1,18 +1,24 @@
 #pragma once
 #include "chess.h"
 #include "Move.h"
+#include "Board.h"
 class Game : private Chess
 {
 public:
 	Game();
 	~Game();
 
+	// Back to the initial position, as if it had just been constructed
+	void reset(void);
+
 	static const char MENU_OPTION_NEW = 'N';
 	static const char MENU_OPTION_MOVE = 'M';
 	static const char MENU_OPTION_QUIT = 'Q';
 	static const char MENU_OPTION_UNDO = 'U';
 	static const char MENU_OPTION_SAVE = 'S';
 	static const char MENU_OPTION_LOAD = 'L';
+	static const char MENU_OPTION_HINT = 'H';
+	static const char MENU_OPTION_COUNTERS = 'C';
 
 	void movePiece(Move* currentMove);
 
@@ -40,6 +46,9 @@ public:
 
 	bool isCheckMate();
 
+	// Checkmate, stalemate or one of the draw rules, worked out from the logged moves
+	Chess::TerminalState terminalState(void) const;
+
 	bool isKingInCheck(int color, IntendedMove* intendedMove = nullptr);
 
 	bool isPlayerKingInCheck(IntendedMove* intendedMove = nullptr);
@@ -48,8 +57,6 @@ public:
 
 	Position findKing(int color);
 
-	void changeTurns(void);
-
 	bool isFinished(void);
 
 	int getCurrentTurn(void);
@@ -58,56 +65,62 @@ public:
 
 	void parseMove(string move, Position* from, Position* to, char* promoted = nullptr);
 
-	void logMove(std::string& record);
+	void deleteLastMove(void);
+
+	// Moves played so far, one compact record per ply (squares as on the engine
+	// Board, flags for captures, castling and promotions). The text forms are
+	// only made for the screen and the saved games
+	size_t getPlyCount(void) const { return history.plies.size(); }
 
-	string getLastMove(void);
+	const CompactMove& getPly(size_t index) const { return history.plies[index]; }
 
-	void deleteLastMove(void);
+	// The current position on its own. A Board is trivially copyable, so analysis can
+	// fork it with one copy and make moves on the copy without touching the game
+	const Board& getPosition(void) const { return position; }
+
+	// "E2-E4  " or "E7-E8=Q", the form of the saved games
+	std::string getRecord(size_t index) const;
+
+	// Writes the game in the saved game format, the one loadGame reads
+	void save(std::ostream& os) const;
 
-	void initCastlingTrue(void);
+	// The position, and the hash key before each move for the repetition rule
+	void toBoard(Board& position, std::vector<uint64_t>& history) const;
 
-	// Save all the moves
+	// The text form of a saved game, for tools that write or read games without playing them
 	struct Round
 	{
 		string whiteMove;
 		string blackMove;
 	};
 
-	//std::deque<std::string> moves;
-	std::deque<Round> rounds;
+	// Writes the moves in the saved game format
+	static void saveRounds(std::ostream& os, const std::deque<Round>& rounds);
 
-	// Save the captured pieces
-	std::vector<char> whiteCaptured;
-	std::vector<char> blackCaptured;
+	// Reads the moves of a saved game without checking them. Lines starting with "["
+	// (the save time, or tags like "[Result] 1-0") go to tags when it is given
+	static void loadRounds(std::istream& is, std::deque<Round>& rounds, std::vector<std::string>* tags = nullptr);
+
+	// Pieces of that color taken so far, in the order they were captured
+	const std::vector<char>& getCaptured(int color) const { return history.captured[color]; }
 
 private:
 
-	// Represent the pieces in the board
-	char board[8][8];
+	// The pieces, the side to move, castling rights, en passant square, clocks and
+	// hash key. Moves are made on it with Board::makeMove, the same as in the engine
+	Board position;
 
-	// Undo is possible?
-	struct Undo
+	// Everything that led to the position, kept apart so the position stays a plain copy
+	struct History
 	{
-		bool undo;
-		bool lastMoveCaptured;
-
-		bool allowedCastlingKingSide;
-		bool allowedCastlingQueenSide;
-
-		EnPassant enPassant;
-		Castling  castling;
-		Promotion promotion;
-
-		void initFalse(void);
-
-	} undoMove;
-
-	// Castling requirements
-	bool castlingKingSideAllowed[2];
-	bool castlingQueenSideAllowed[2];
-
-	// Holds the current turn
-	int  currentTurn;
+		std::vector<CompactMove> plies;
+		std::vector<uint64_t>    keys;        // Hash key of the position before each ply
+		std::vector<char>        captured[2]; // By the color of the captured piece
+		Board                    beforeLast;  // Undoing the last ply puts this back
+		bool                     undo;        // Undo is possible?
+	} history;
+
+	static void writeSaveTime(std::ostream& os);
 
 	// Has the game finished already?
 	bool gameFinished;
@@ -1,8 +1,56 @@
 #include "GameController.h"
+#include "UciController.h"
+#include "Bench.h"
+#include "Counters.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Builds with CHESS_COUNTERS print what the rules did when leaving, builds
+	// with CHESS_ALLOC_TRACKING what was allocated and never freed, and builds
+	// with CHESS_TRACE write the trace file
+	Counters::dumpAtExit();
+	AllocationTracker::reportAtExit();
+	Trace::writeAtExit();
+	Trace::setThreadName("main");
+
+	// "--uci" turns the console game into an engine for GUIs and match tools
+	if (argc > 1 && 0 == strcmp(argv[1], "--uci"))
+	{
+		UciController uciController;
+		uciController.loop();
+		return 0;
+	}
+
+	// "bench [depth]" searches a fixed set of positions and prints the node count and speed
+	if (argc > 1 && 0 == strcmp(argv[1], "bench"))
+	{
+		int depth = argc > 2 ? atoi(argv[2]) : Bench::DEFAULT_DEPTH;
+		Bench::run(depth > 0 ? depth : Bench::DEFAULT_DEPTH, cout);
+		return 0;
+	}
+
+	// "--script [file]" runs menu commands from the file (or from stdin) without any prompts or redraws
+	if (argc > 1 && 0 == strcmp(argv[1], "--script"))
+	{
+		GameController gameController;
+		if (argc > 2 && 0 != strcmp(argv[2], "-"))
+		{
+			std::ifstream ifs(argv[2]);
+			if (!ifs)
+			{
+				cout << "Can't open " << argv[2] << "\n";
+				return 1;
+			}
+			return gameController.runScript(ifs, cout) > 0 ? 1 : 0;
+		}
+		return gameController.runScript(cin, cout) > 0 ? 1 : 0;
+	}
+
+	// "--diff" keeps the board on screen and repaints only the squares that changed
 	GameController gameController;
+	gameController.setDifferentialRedraw(argc > 1 && 0 == strcmp(argv[1], "--diff"));
 	gameController.loadMenu();
 
 	return 0;